@@ -0,0 +1,116 @@
+#include <string>
+#include <vector>
+#include "engine.h"
+#include "harness.h"
+#include "random.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    // The toy parameters the sweep uses for the one-word backends, drawn from a fixed seed
+    const group& toy_group()
+    {
+        static const group G = [] {
+            reseedThread(0);
+            return getGroupParameters(20, 40);
+        }();
+        return G;
+    }
+
+    const small_group& toy_small_group()
+    {
+        static const small_group G = [] {
+            reseedThread(0);
+            return small_group(getGroupParameters(16, 15));
+        }();
+        return G;
+    }
+
+    template<group_backend G>
+    const G& backend();
+    template<> const small_group& backend<small_group>() { return toy_small_group(); }
+    template<> const group& backend<group>() { return toy_group(); }
+    template<> const modp2048& backend<modp2048>() { static const modp2048 G = modp2048::rfc3526(); return G; }
+    template<> const modp3072& backend<modp3072>() { static const modp3072 G = modp3072::rfc3526(); return G; }
+
+    // Random elements and exponents of the backend, drawn from a fixed seed
+    template<group_backend G>
+    struct operands
+    {
+        vector<typename G::element> elements;
+        vector<typename G::exponent> exponents;
+
+        explicit operands(const G& grp, size_t n = 64)
+        {
+            reseedThread(1);
+            constexpr size_t k = G::exponent_draws;
+            vector<uint64_t> draws(2 * k * n);
+            grp.random(draws);
+            for (size_t i = 0; i < n; ++i)
+            {
+                exponents.push_back(grp.to_exponent(span(draws).subspan(2 * k * i, k)));
+                elements.push_back(grp.pow_g(grp.to_exponent(span(draws).subspan(2 * k * i + k, k))));
+            }
+        }
+    };
+
+    template<group_backend G>
+    void mul(bench_state& state)
+    {
+        const G &grp = backend<G>();
+        operands<G> const in(grp);
+        for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(grp.mul(in.elements[i & 63], in.elements[(i + 1) & 63]));
+    }
+
+    template<group_backend G>
+    void pow(bench_state& state)
+    {
+        const G &grp = backend<G>();
+        operands<G> const in(grp);
+        for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(grp.pow(in.elements[i & 63], in.exponents[i & 63]));
+    }
+
+    template<group_backend G>
+    void pow_g(bench_state& state)
+    {
+        const G &grp = backend<G>();
+        operands<G> const in(grp);
+        for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(grp.pow_g(in.exponents[i & 63]));
+    }
+
+    // One full search of a 30-node scale-free graph for cycles of length up to 3 per iteration
+    template<group_backend G>
+    void run(bench_state& state)
+    {
+        static const graph topology = get<2>(generate_scale_free_graph(3, 3, 30, 1));
+        basic_simulation<G> sim(topology, backend<G>(), 1);
+        run_stats stats;
+        for (uint64_t i = 0; i < state.iterations; ++i)
+        {
+            stats = run_serial(sim, 3);
+            do_not_optimize(stats.messages);
+        }
+        state.counter("messages", stats.messages);
+        state.counter("message_bytes", sizeof(basic_message<G>));
+        state.counter("peak_bytes", (double) stats.peak_bytes);
+    }
+
+    template<group_backend G>
+    void register_backend(const string& name)
+    {
+        register_benchmark("backend_mul_" + name, mul<G>);
+        register_benchmark("backend_pow_" + name, pow<G>);
+        register_benchmark("backend_pow_g_" + name, pow_g<G>);
+        register_benchmark("backend_run_" + name, run<G>);
+    }
+
+    [[maybe_unused]] const bool registered = [] {
+        register_backend<small_group>("small");
+        register_backend<group>("mont64");
+        register_backend<modp2048>("modp2048");
+        register_backend<modp3072>("modp3072");
+        return true;
+    }();
+}
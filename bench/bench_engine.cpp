@@ -0,0 +1,57 @@
+#include <memory>
+#include <thread>
+#include <vector>
+#include "engine.h"
+#include "harness.h"
+#include "random.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    // A 200-node scale-free graph searched for cycles of length up to 3
+    struct workload
+    {
+        group G;
+        graph topology;
+
+        workload()
+        {
+            reseedThread(0);
+            G = getGroupParameters(20, 40);
+            topology = get<2>(generate_scale_free_graph(4, 4, 200, 1));
+        }
+    };
+
+    const workload& shared_workload()
+    {
+        static const workload w;
+        return w;
+    }
+
+    // One full run over all initiators per iteration, so ns/op is the run's wall-clock time
+    void run_threads(bench_state& state, unsigned threads)
+    {
+        const workload &w = shared_workload();
+        thread_pool pool(threads);
+        vector<unique_ptr<simulation>> replicas;
+        for (unsigned t = 0; t < threads; ++t) replicas.push_back(make_unique<simulation>(w.topology, w.G, 1));
+        for (uint64_t i = 0; i < state.iterations; ++i)
+        {
+            auto stats = threads > 1 ? run_parallel(pool, replicas, 3) : run_serial(*replicas[0], 3);
+            do_not_optimize(stats.messages);
+        }
+    }
+
+    // Scaling cases for 1, 2, 4, ... threads up to the number of hardware threads
+    [[maybe_unused]] const bool registered = [] {
+        unsigned const hw = max(1U, thread::hardware_concurrency());
+        for (unsigned t = 1;; t = min(t * 2, hw))
+        {
+            register_benchmark("run_parallel_threads_" + to_string(t), [t](bench_state& state) { run_threads(state, t); });
+            if (t == hw) break;
+        }
+        return true;
+    }();
+}
@@ -0,0 +1,34 @@
+#include <string>
+#include <thread>
+#include "harness.h"
+#include "thread_pool.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    // One graph per iteration, all from seed 1, so every run builds the same graphs
+    void scale_free(bench_state& state, int n, int m, thread_pool *pool)
+    {
+        int edges = 0;
+        for (uint64_t i = 0; i < state.iterations; ++i)
+        {
+            edges = get<0>(generate_scale_free_graph(m, m, n, 1, pool));
+            do_not_optimize(edges);
+        }
+        state.counter("edges", edges);
+    }
+
+    [[maybe_unused]] const bool registered = [] {
+        for (int n : { 1000, 10000, 100000 })
+            for (int m : { 2, 4, 8 })
+                register_benchmark("generate_ba_n" + to_string(n) + "_m" + to_string(m),
+                                   [=](bench_state& s) { scale_free(s, n, m, nullptr); });
+        register_benchmark("generate_ba_n100000_m8_parallel", [](bench_state& s) {
+            thread_pool pool(max(1U, thread::hardware_concurrency()));
+            scale_free(s, 100000, 8, &pool);
+        });
+        return true;
+    }();
+}
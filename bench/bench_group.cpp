@@ -0,0 +1,52 @@
+#include <vector>
+#include "harness.h"
+#include "group.h"
+#include "random.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    // A group with a 40-bit subgroup order, so exponents of up to 40 bits stay unreduced
+    const group& wide_group()
+    {
+        static const group G = [] {
+            reseedThread(0);
+            return getGroupParameters(40, 20);
+        }();
+        return G;
+    }
+
+    vector<uint64_t> exponents(int bits, size_t n = 1024)
+    {
+        reseedThread(1);
+        vector<uint64_t> v(n);
+        fillRandomBelow(1ULL << bits, v);
+        return v;
+    }
+
+    void pow_plain(bench_state& state, int bits)
+    {
+        const group& G = wide_group();
+        auto e = exponents(bits);
+        for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(G.pow(G.g, e[i & 1023]));
+    }
+
+    void pow_fixed_base(bench_state& state, int bits)
+    {
+        const group& G = wide_group();
+        auto e = exponents(bits);
+        do_not_optimize(G.pow_g(1));  // build the table outside the timed loop
+        for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(G.pow_g(e[i & 1023]));
+    }
+}
+
+BENCHMARK(pow_g_plain_10bit)       { pow_plain(state, 10); }
+BENCHMARK(pow_g_fixed_base_10bit)  { pow_fixed_base(state, 10); }
+BENCHMARK(pow_g_plain_20bit)       { pow_plain(state, 20); }
+BENCHMARK(pow_g_fixed_base_20bit)  { pow_fixed_base(state, 20); }
+BENCHMARK(pow_g_plain_30bit)       { pow_plain(state, 30); }
+BENCHMARK(pow_g_fixed_base_30bit)  { pow_fixed_base(state, 30); }
+BENCHMARK(pow_g_plain_40bit)       { pow_plain(state, 40); }
+BENCHMARK(pow_g_fixed_base_40bit)  { pow_fixed_base(state, 40); }
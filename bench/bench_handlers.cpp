@@ -0,0 +1,122 @@
+#include <numeric>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "harness.h"
+#include "node.h"
+#include "random.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    const group& group_of(int q_bits, int r_bits)
+    {
+        static const group narrow = [] { reseedThread(0); return getGroupParameters(20, 40); }();
+        static const group wide = [] { reseedThread(0); return getGroupParameters(40, 20); }();
+        return q_bits == 20 && r_bits == 40 ? narrow : wide;
+    }
+
+    // Node 0 with out-neighbours 1..degree, its state held as a simulation would hold it. State is
+    // dropped every 1024 messages, so the handlers see a node about as busy as a hub in one instance.
+    struct handler_bench
+    {
+        const group &G;
+        vector<int> neighbours;
+        arena mem;
+        node_states states{ &mem };
+        path_store paths;
+        vector<uint64_t> nonces, elements;
+        vector<uint64_t> t_nonces, s_nonces, b_keys;
+        path_ref incoming;
+
+        handler_bench(const group& G, int degree) : G(G), neighbours(degree), nonces(1024), elements(1024)
+        {
+            iota(neighbours.begin(), neighbours.end(), 1);
+            reseedThread(6);
+            for (auto &r : nonces) r = getRandomBelow(UINT64_MAX);
+            fillRandomInGroup(G, elements);
+            restart();
+        }
+
+        node self() { return { 0, neighbours, states, 0, G, &paths, 0 }; }
+
+        // Fresh state holding one forwarded instance, answered on every route for the publish phase
+        void restart()
+        {
+            states.clear();
+            mem.rewind();
+            paths.clear();
+            states.add(0);
+            vector<message> out;
+            self().forward(message((int) neighbours.size() + 1, 0, nonces[0], elements[0], 2), out);
+            t_nonces.clear();
+            for (size_t i = 1; i < out.size(); ++i) t_nonces.push_back(out[i].r);
+            s_nonces.clear();
+            b_keys.clear();
+            for (size_t k = 0; k < t_nonces.size(); ++k)
+            {
+                out.clear();
+                self().backward(message(neighbours[k], 0, t_nonces[k], elements[k + 1]), out);
+                s_nonces.push_back(out[0].r);
+                b_keys.push_back(out[0].gx);
+            }
+            incoming = paths.extend({}, (int) neighbours.size() + 1);
+        }
+    };
+
+    void forward(bench_state& state, int q_bits, int r_bits, int degree)
+    {
+        handler_bench b(group_of(q_bits, r_bits), degree);
+        vector<message> out;
+        for (uint64_t i = 0; i < state.iterations; ++i)
+        {
+            if ((i & 1023) == 1023) b.restart();
+            out.clear();
+            b.self().forward(message(degree + 1, 0, b.nonces[i & 1023], b.elements[i & 1023], 2), out);
+            do_not_optimize(out.data());
+        }
+    }
+
+    void backward(bench_state& state, int q_bits, int r_bits, int degree)
+    {
+        handler_bench b(group_of(q_bits, r_bits), degree);
+        vector<message> out;
+        for (uint64_t i = 0; i < state.iterations; ++i)
+        {
+            if ((i & 1023) == 1023) b.restart();
+            size_t const k = i % (size_t) degree;
+            out.clear();
+            b.self().backward(message(b.neighbours[k], 0, b.t_nonces[k], b.elements[i & 1023]), out);
+            do_not_optimize(out.data());
+        }
+    }
+
+    void publish(bench_state& state, int q_bits, int r_bits, int degree)
+    {
+        handler_bench b(group_of(q_bits, r_bits), degree);
+        vector<message> out;
+        for (uint64_t i = 0; i < state.iterations; ++i)
+        {
+            if ((i & 1023) == 1023) b.restart();
+            size_t const k = i % (size_t) degree;
+            out.clear();
+            b.self().publish(message(b.neighbours[k], 0, b.s_nonces[k], b.b_keys[k], b.incoming), out);
+            do_not_optimize(out.data());
+        }
+    }
+
+    // Every handler at degrees 2, 8 and 32 in the default group and in one with a 40-bit subgroup
+    [[maybe_unused]] const bool registered = [] {
+        for (auto [q_bits, r_bits] : { pair{ 20, 40 }, pair{ 40, 20 } })
+            for (int degree : { 2, 8, 32 })
+            {
+                string const suffix = "_q" + to_string(q_bits) + "_d" + to_string(degree);
+                register_benchmark("handler_forward" + suffix, [=](bench_state& s) { forward(s, q_bits, r_bits, degree); });
+                register_benchmark("handler_backward" + suffix, [=](bench_state& s) { backward(s, q_bits, r_bits, degree); });
+                register_benchmark("handler_publish" + suffix, [=](bench_state& s) { publish(s, q_bits, r_bits, degree); });
+            }
+        return true;
+    }();
+}
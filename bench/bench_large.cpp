@@ -0,0 +1,76 @@
+#include <chrono>
+#include <thread>
+#include "engine.h"
+#include "harness.h"
+#include "random.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    // A scale-free graph of a million nodes, built once for all cases
+    struct workload
+    {
+        group G;
+        graph topology;
+
+        workload()
+        {
+            reseedThread(0);
+            G = getGroupParameters(20, 40);
+            topology = get<2>(generate_scale_free_graph(4, 4, 1000000, 1));
+        }
+    };
+
+    const workload& shared_workload()
+    {
+        static const workload w;
+        return w;
+    }
+}
+
+// Setting up a simulation costs one slot index entry per node; state arrays grow only with use
+BENCHMARK(simulation_build_1M)
+{
+    const workload &w = shared_workload();
+    size_t bytes = 0;
+    for (uint64_t i = 0; i < state.iterations; ++i)
+    {
+        simulation sim(w.topology, w.G, 1);
+        bytes = sim.bytes();
+        do_not_optimize(bytes);
+    }
+    state.counter("graph_bytes", (double) w.topology.bytes());
+    state.counter("sim_bytes", (double) bytes);
+}
+
+// One instance of length 3 per iteration; ns/op is per instance. Initiators are spread over the id
+// range from the newest node down, since the oldest nodes are the hubs the graph grew around.
+BENCHMARK(instances_1M_l3)
+{
+    const workload &w = shared_workload();
+    simulation sim(w.topology, w.G, 1);
+    sim.reset();
+    run_stats stats(3);
+    auto t1 = chrono::steady_clock::now();
+    for (uint64_t i = 0; i < state.iterations; ++i)
+        run_instance(sim, sim.size() - 1 - (int) (i * 7919 % (uint64_t) sim.size()), 3, stats);
+    auto t2 = chrono::steady_clock::now();
+    double const seconds = chrono::duration<double>(t2 - t1).count();
+    if (seconds > 0) state.counter("msgs_per_s", (double) stats.messages / seconds);
+    state.counter("peak_state_bytes", (double) sim.peak_bytes());
+    state.counter("sim_bytes", (double) sim.bytes());
+}
+
+// Preferential attachment over a million nodes, on the calling thread and on all hardware threads
+BENCHMARK(generate_ba_1M_serial)
+{
+    for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(get<0>(generate_scale_free_graph(4, 4, 1000000, i)));
+}
+
+BENCHMARK(generate_ba_1M_parallel)
+{
+    thread_pool pool(max(1U, thread::hardware_concurrency()));
+    for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(get<0>(generate_scale_free_graph(4, 4, 1000000, i, &pool)));
+}
@@ -0,0 +1,108 @@
+#include <vector>
+#include "harness.h"
+#include "modarith.h"
+#include "random.h"
+
+using namespace std;
+
+namespace
+{
+    // The bit-serial arithmetic that modarith replaced, kept as a baseline
+    int legacyMulMod(int a, int b, int m) {
+        int res = 0;
+        while (a != 0) {
+            if (a & 1) res = (res + b) % m;
+            a >>= 1;
+            b = (b << 1) % m;
+        }
+        return res;
+    }
+
+    int legacyPowMod(int a, int b, int n) {
+        int x = 1;
+        a %= n;
+        while (b > 0) {
+            if (b & 1) x = legacyMulMod(x, a, n);
+            a = legacyMulMod(a, a, n);
+            b >>= 1;
+        }
+        return x % n;
+    }
+
+    // Plain square-and-multiply with a 128-bit division per product
+    uint64_t divisionPowMod(uint64_t a, uint64_t b, uint64_t n) {
+        uint64_t x = 1;
+        a %= n;
+        while (b > 0) {
+            if (b & 1) x = mulMod(x, a, n);
+            a = mulMod(a, a, n);
+            b >>= 1;
+        }
+        return x;
+    }
+
+    constexpr uint64_t p30 = 1073741789;            // largest prime below 2^30
+    constexpr uint64_t p62 = 4611686018427387847;   // largest prime below 2^62
+
+    vector<uint64_t> operands(uint64_t bound, size_t n = 1024)
+    {
+        reseedThread(0);
+        vector<uint64_t> v(n);
+        fillRandomBelow(bound, v);
+        return v;
+    }
+}
+
+BENCHMARK(powmod_legacy_30bit)
+{
+    auto v = operands(p30);
+    for (uint64_t i = 0; i < state.iterations; ++i)
+        do_not_optimize(legacyPowMod((int) v[i & 1023], (int) v[(i + 1) & 1023], (int) p30));
+}
+
+BENCHMARK(powmod_division_30bit)
+{
+    auto v = operands(p30);
+    for (uint64_t i = 0; i < state.iterations; ++i)
+        do_not_optimize(divisionPowMod(v[i & 1023], v[(i + 1) & 1023], p30));
+}
+
+BENCHMARK(powmod_montgomery_30bit)
+{
+    auto v = operands(p30);
+    montgomery const mont(p30);
+    for (uint64_t i = 0; i < state.iterations; ++i)
+        do_not_optimize(mont.pow(v[i & 1023], v[(i + 1) & 1023]));
+}
+
+BENCHMARK(powmod_division_62bit)
+{
+    auto v = operands(p62);
+    for (uint64_t i = 0; i < state.iterations; ++i)
+        do_not_optimize(divisionPowMod(v[i & 1023], v[(i + 1) & 1023], p62));
+}
+
+BENCHMARK(powmod_montgomery_62bit)
+{
+    auto v = operands(p62);
+    montgomery const mont(p62);
+    for (uint64_t i = 0; i < state.iterations; ++i)
+        do_not_optimize(mont.pow(v[i & 1023], v[(i + 1) & 1023]));
+}
+
+BENCHMARK(mulmod_division_62bit)
+{
+    auto v = operands(p62);
+    uint64_t x = v[0];
+    for (uint64_t i = 0; i < state.iterations; ++i) x = mulMod(x, v[i & 1023], p62);
+    do_not_optimize(x);
+}
+
+BENCHMARK(mulmod_montgomery_62bit)
+{
+    auto v = operands(p62);
+    montgomery const mont(p62);
+    uint64_t x = v[0];
+    for (uint64_t i = 0; i < state.iterations; ++i) x = mont.mul(x, v[i & 1023]);
+    do_not_optimize(x);
+}
@@ -0,0 +1,35 @@
+#include <vector>
+#include "harness.h"
+#include "powbatch.h"
+#include "random.h"
+
+using namespace std;
+
+namespace
+{
+    constexpr uint64_t p30 = 1073741789;            // largest prime below 2^30
+    constexpr uint64_t p50 = 1125899906842597;      // largest prime below 2^50
+    constexpr size_t lanes = 256;
+
+    // One batch of lanes exponentiations per iteration, reported per batch
+    void pow_batch(bench_state& state, uint64_t n, pow_kernel kernel, int exp_bits)
+    {
+        if (!pow_batcher::supported(kernel, n)) return;
+        pow_batcher const batch(n, kernel);
+        reseedThread(0);
+        vector<uint64_t> bases(lanes), exps(lanes), out(lanes);
+        fillRandomBelow(n, bases);
+        fillRandomBelow(1ULL << exp_bits, exps);
+        for (uint64_t i = 0; i < state.iterations; ++i)
+        {
+            batch(bases, exps, out);
+            do_not_optimize(out.data());
+        }
+    }
+}
+
+BENCHMARK(pow_batch256_scalar_30bit)  { pow_batch(state, p30, pow_kernel::scalar, 20); }
+BENCHMARK(pow_batch256_avx2_30bit)    { pow_batch(state, p30, pow_kernel::avx2, 20); }
+BENCHMARK(pow_batch256_avx512_30bit)  { pow_batch(state, p30, pow_kernel::avx512, 20); }
+BENCHMARK(pow_batch256_scalar_50bit)  { pow_batch(state, p50, pow_kernel::scalar, 20); }
+BENCHMARK(pow_batch256_avx512_50bit)  { pow_batch(state, p50, pow_kernel::avx512, 20); }
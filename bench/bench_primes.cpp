@@ -0,0 +1,67 @@
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "harness.h"
+#include "modarith.h"
+#include "random.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    // Random odd candidates of exactly the given size; mostly composite, as in a prime search
+    vector<uint64_t> candidates(int bits, size_t n = 1024)
+    {
+        reseedThread(2);
+        vector<uint64_t> v(n);
+        for (auto &c : v) c = getRandomOfSize(bits) | 1;
+        return v;
+    }
+
+    // Primes of exactly the given size, the slow path of every test
+    vector<uint64_t> primes(int bits, size_t n = 64)
+    {
+        reseedThread(3);
+        vector<uint64_t> v(n);
+        for (auto &c : v) c = getBigPrime(bits);
+        return v;
+    }
+
+    const int sizes[] = { 20, 30, 40, 62 };
+
+    [[maybe_unused]] const bool registered = [] {
+        for (int bits : sizes)
+        {
+            string const suffix = "_" + to_string(bits) + "bit";
+            register_benchmark("powmod" + suffix, [bits](bench_state& state) {
+                auto v = candidates(bits);
+                for (uint64_t i = 0; i < state.iterations; ++i)
+                    do_not_optimize(powMod(v[i & 1023], v[(i + 1) & 1023], v[(i + 2) & 1023]));
+            });
+            register_benchmark("miller_rabin_candidate" + suffix, [bits](bench_state& state) {
+                auto v = candidates(bits);
+                for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(millerRabinTest(v[i & 1023]));
+            });
+            register_benchmark("miller_rabin_prime" + suffix, [bits](bench_state& state) {
+                auto v = primes(bits);
+                for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(millerRabinTest(v[i & 63]));
+            });
+        }
+        // Group setup as the experiments run it, for a small, the default and a wide subgroup
+        for (auto [q_bits, r_bits] : { pair{ 10, 20 }, pair{ 20, 40 }, pair{ 40, 20 } })
+            register_benchmark("group_parameters_q" + to_string(q_bits) + "_r" + to_string(r_bits), [q_bits, r_bits](bench_state& state) {
+                reseedThread(5);
+                for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(getGroupParameters(q_bits, r_bits).p);
+            });
+        // Startup with a warm cache: reading and validating the stored set
+        register_benchmark("group_parameters_cached_q20_r40", [](bench_state& state) {
+            string const path = (filesystem::temp_directory_path() / "cycle_detection_bench_groups.txt").string();
+            filesystem::remove(path);
+            cachedGroupParameters(20, 40, path);
+            for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(cachedGroupParameters(20, 40, path).p);
+            filesystem::remove(path);
+        });
+        return true;
+    }();
+}
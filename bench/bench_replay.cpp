@@ -0,0 +1,74 @@
+#include <vector>
+#include "engine.h"
+#include "harness.h"
+#include "random.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    // A recorded run of a 200-node scale-free graph searched for cycles of length up to 3, the
+    // workload of the run_parallel cases
+    struct recording
+    {
+        group G;
+        graph topology;
+        trace_run run;
+
+        recording()
+        {
+            reseedThread(0);
+            G = getGroupParameters(20, 40);
+            topology = get<2>(generate_scale_free_graph(4, 4, 200, 1));
+            run = record_run();
+        }
+
+        [[nodiscard]] trace_run record_run() const
+        {
+            trace_run recorded("mont64", topology, 1, 3, 3);
+            simulation sim(topology, G, 1);
+            run_options options;
+            options.trace = &recorded;
+            run_serial(sim, 3, options);
+            return recorded;
+        }
+    };
+
+    const recording& shared_recording()
+    {
+        static const recording r;
+        return r;
+    }
+
+    // The run as the sweep's trace= records it, for the recording's cost over run_parallel_threads_1
+    void record(bench_state& state)
+    {
+        const recording &r = shared_recording();
+        for (uint64_t i = 0; i < state.iterations; ++i) do_not_optimize(r.record_run().instances.size());
+        state.counter("trace_bytes_per_msg", (double) r.run.bytes() / (double) r.run.messages());
+    }
+
+    // The nodes' work alone, or the engine's queue alone, per run
+    void replay_in(bench_state& state, replay_mode mode)
+    {
+        const recording &r = shared_recording();
+        simulation sim(r.topology, r.G, 1);
+        int64_t decode_ns = 0;
+        for (uint64_t i = 0; i < state.iterations; ++i)
+        {
+            run_stats const stats = replay(sim, r.run, mode);
+            decode_ns += stats.trace_decode_ns;
+            do_not_optimize(stats.messages);
+        }
+        state.counter("messages", (double) r.run.messages());
+        state.counter("decode_ns_per_run", (double) decode_ns / (double) state.iterations);
+    }
+
+    [[maybe_unused]] const bool registered = [] {
+        register_benchmark("trace_record", record);
+        register_benchmark("replay_handlers", [](bench_state& state) { replay_in(state, replay_mode::handlers); });
+        register_benchmark("replay_dispatch", [](bench_state& state) { replay_in(state, replay_mode::dispatch); });
+        return true;
+    }();
+}
@@ -0,0 +1,53 @@
+#include <queue>
+#include <vector>
+#include "harness.h"
+#include "latency.h"
+#include "random.h"
+#include "timing_wheel.h"
+
+using namespace std;
+
+namespace
+{
+    constexpr uint32_t pending = 4096;      // events in flight, like a busy instance
+    constexpr uint64_t batch = 1 << 16;     // events per iteration
+
+    // Hold model: every popped event schedules one more at a delay drawn from the distribution
+    void hold(bench_state& state, const string& spec)
+    {
+        latency_model const latency{ delay_dist::parse(spec), {}, 1 };
+        timing_wheel wheel;
+        for (uint32_t id = 0; id < pending; ++id) wheel.push(id, latency.delay_ns((int) id, 0, id));
+        uint64_t sent = pending;
+        for (uint64_t i = 0; i < state.iterations; ++i)
+            for (uint64_t k = 0; k < batch; ++k)
+            {
+                uint32_t id;
+                wheel.pop(id);
+                wheel.push(id, wheel.now() + latency.delay_ns((int) id, 1, sent++));
+            }
+        do_not_optimize(wheel.now());
+        state.counter("events_per_batch", (double) batch);
+    }
+}
+
+BENCHMARK(timing_wheel_hold64k_uniform)   { hold(state, "uniform:50:150"); }
+BENCHMARK(timing_wheel_hold64k_lognormal) { hold(state, "lognormal:500:1"); }
+
+// The same hold model on a binary heap of (time, id) pairs, for comparison
+BENCHMARK(heap_hold64k_lognormal)
+{
+    latency_model const latency{ delay_dist::parse("lognormal:500:1"), {}, 1 };
+    priority_queue<pair<uint64_t, uint32_t>, vector<pair<uint64_t, uint32_t>>, greater<>> heap;
+    for (uint32_t id = 0; id < pending; ++id) heap.emplace(latency.delay_ns((int) id, 0, id), id);
+    uint64_t sent = pending;
+    for (uint64_t i = 0; i < state.iterations; ++i)
+        for (uint64_t k = 0; k < batch; ++k)
+        {
+            auto const [now, id] = heap.top();
+            heap.pop();
+            heap.emplace(now + latency.delay_ns((int) id, 1, sent++), id);
+        }
+    do_not_optimize(heap.top());
+    state.counter("events_per_batch", (double) batch);
+}
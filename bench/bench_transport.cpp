@@ -0,0 +1,82 @@
+#include <vector>
+#include "harness.h"
+#include "random.h"
+#include "transport.h"
+#include "wire.h"
+
+using namespace std;
+
+namespace
+{
+    constexpr size_t batch = 256;
+
+    // A batch of forwards, backwards and publishes with 4-node paths, in roughly the mix a search sends
+    vector<message> sample(path_store& paths)
+    {
+        reseedThread(0);
+        vector<message> msgs;
+        path_ref path;
+        for (int v : { 3, 141, 59, 26 }) path = paths.extend(path, v);
+        for (size_t i = 0; i < batch; ++i)
+        {
+            auto const r = getRandomBelow(1ULL << 40), gx = getRandomBelow(1ULL << 40);
+            auto const source = (int) getRandomBelow(100000), target = (int) getRandomBelow(100000);
+            message &msg = i % 8 == 0 ? msgs.emplace_back(source, target, r, gx, path)
+                         : i % 3 == 0 ? msgs.emplace_back(source, target, r, gx, 2)
+                         : msgs.emplace_back(source, target, r, gx);
+            msg.hop = 2;
+        }
+        return msgs;
+    }
+
+    // One batch through the transport per iteration
+    void carry(bench_state& state, transport_kind kind)
+    {
+        path_store paths;
+        vector<message> const msgs = sample(paths);
+        unique_ptr<transport> link = make_transport(kind);
+        vector<message> out;
+        for (uint64_t i = 0; i < state.iterations; ++i)
+        {
+            out = msgs;
+            link->carry(out, 0, paths);
+            do_not_optimize(out.data());
+            if (paths.size() > (1U << 20)) paths.clear();
+        }
+        auto const &stats = link->stats();
+        state.counter("bytes_per_msg", stats.messages ? (double) stats.wire_bytes / (double) stats.messages : 0);
+    }
+}
+
+BENCHMARK(wire_encode256)
+{
+    path_store paths;
+    vector<message> const msgs = sample(paths);
+    vector<uint8_t> bytes;
+    for (uint64_t i = 0; i < state.iterations; ++i)
+    {
+        bytes.clear();
+        for (const message &msg : msgs) encode(msg, paths, bytes);
+        do_not_optimize(bytes.data());
+    }
+    state.counter("bytes_per_msg", (double) bytes.size() / batch);
+}
+
+BENCHMARK(wire_decode256)
+{
+    path_store paths;
+    vector<message> const msgs = sample(paths);
+    vector<uint8_t> bytes;
+    for (const message &msg : msgs) encode(msg, paths, bytes);
+    for (uint64_t i = 0; i < state.iterations; ++i)
+    {
+        span<const uint8_t> in(bytes);
+        while (!in.empty()) do_not_optimize(decode<group>(in, paths));
+        if (paths.size() > (1U << 20)) paths.clear();
+    }
+}
+
+BENCHMARK(transport256_inproc) { carry(state, transport_kind::in_process); }
+BENCHMARK(transport256_shm)    { carry(state, transport_kind::shared_memory); }
+BENCHMARK(transport256_unix)   { carry(state, transport_kind::unix_socket); }
+BENCHMARK(transport256_tcp)    { carry(state, transport_kind::tcp_socket); }
@@ -0,0 +1,34 @@
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Minimal self-contained benchmark harness: each case runs its body state.iterations times
+struct bench_state
+{
+    uint64_t iterations;
+    vector<pair<string, double>> counters;   // extra figures a case reports next to its timing
+
+    void counter(const string& name, double value) { counters.emplace_back(name, value); }
+};
+
+using bench_fn = function<void(bench_state&)>;
+
+bool register_benchmark(const string& name, bench_fn fn);
+
+// Keeps the compiler from discarding a value whose computation is being measured
+template <typename T>
+inline void do_not_optimize(T const& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+#define BENCHMARK(name)                                                                  \
+    static void name(bench_state&);                                                      \
+    [[maybe_unused]] static const bool name##_registered = register_benchmark(#name, name); \
+    static void name(bench_state& state)
+
+#endif
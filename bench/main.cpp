@@ -0,0 +1,88 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "harness.h"
+#include "random.h"
+
+using namespace std;
+
+namespace
+{
+    constexpr uint64_t bench_seed = 1;
+
+    vector<pair<string, bench_fn>>& registry()
+    {
+        static vector<pair<string, bench_fn>> benchmarks;
+        return benchmarks;
+    }
+
+    // Seconds taken by one run of the case with the given iteration count
+    double time_case(const bench_fn& fn, bench_state& state)
+    {
+        state.counters.clear();
+        auto t1 = chrono::steady_clock::now();
+        fn(state);
+        auto t2 = chrono::steady_clock::now();
+        return chrono::duration<double>(t2 - t1).count();
+    }
+}
+
+bool register_benchmark(const string& name, bench_fn fn)
+{
+    registry().emplace_back(name, std::move(fn));
+    return true;
+}
+
+// Runs every registered benchmark whose name contains the optional filter argument. With --json the
+// results go to stdout as one JSON document for comparing runs, and the table to stderr.
+int main(int argc, char *argv[])
+{
+    string filter;
+    bool json = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (string(argv[i]) == "--json") json = true;
+        else filter = argv[i];
+    }
+    // Every fixture draws from streams of this seed, so runs measure the same inputs
+    setMasterSeed(bench_seed);
+
+    ostream &table = json ? cerr : cout;
+    table << left << setw(40) << "benchmark" << right << setw(14) << "iterations" << setw(14) << "ns/op" << '\n';
+    if (json)
+        cout << "{\n  \"context\": { \"seed\": " << bench_seed << ", \"hardware_threads\": " << thread::hardware_concurrency()
+             << " },\n  \"benchmarks\": [";
+    bool first = true;
+    for (const auto& [name, fn] : registry())
+    {
+        if (name.find(filter) == string::npos) continue;
+        // Grow the iteration count until a run lasts long enough to time reliably
+        // A run without iterations builds any fixtures the case shares outside the timing
+        bench_state state{0, {}};
+        time_case(fn, state);
+        state.iterations = 1;
+        double seconds = time_case(fn, state);
+        while (seconds < 0.2 && state.iterations < (1ULL << 40))
+        {
+            state.iterations *= seconds > 0.002 ? (uint64_t) (0.25 / seconds) + 1 : 10;
+            seconds = time_case(fn, state);
+        }
+        double const ns_per_op = seconds * 1e9 / (double) state.iterations;
+        table << left << setw(40) << name << right << setw(14) << state.iterations
+              << setw(14) << fixed << setprecision(2) << ns_per_op;
+        for (const auto& [counter, value] : state.counters) table << "  " << counter << '=' << value;
+        table << '\n';
+
+        if (!json) continue;
+        cout << (first ? "\n" : ",\n") << "    { \"name\": \"" << name << "\", \"iterations\": " << state.iterations
+             << ", \"ns_per_op\": " << ns_per_op << ", \"counters\": {";
+        for (size_t i = 0; i < state.counters.size(); ++i)
+            cout << (i ? ", " : " ") << '"' << state.counters[i].first << "\": " << state.counters[i].second << (i + 1 == state.counters.size() ? " " : "");
+        cout << "} }";
+        first = false;
+    }
+    if (json) cout << "\n  ]\n}\n";
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include <algorithm>
+#include <cstdint>
+#include "arena.h"
+
+using namespace std;
+
+void arena::rewind()
+{
+    current = 0;
+    offset = 0;
+    in_use = 0;
+}
+
+size_t arena::reserved() const
+{
+    size_t total = 0;
+    for (const auto& c : chunks) total += c.size;
+    return total;
+}
+
+void* arena::do_allocate(size_t bytes, size_t alignment)
+{
+    while (current < chunks.size())
+    {
+        chunk &c = chunks[current];
+        auto const base = reinterpret_cast<uintptr_t>(c.data.get());
+        size_t const start = ((base + offset + alignment - 1) & ~(uintptr_t) (alignment - 1)) - base;
+        if (start + bytes <= c.size)
+        {
+            offset = start + bytes;
+            in_use += bytes;
+            high_water = max(high_water, in_use);
+            return c.data.get() + start;
+        }
+        // The tail of this chunk stays unused until the next rewind
+        ++current;
+        offset = 0;
+    }
+    size_t const size = max(chunk_size, bytes + alignment);
+    chunks.push_back({ make_unique_for_overwrite<byte[]>(size), size });
+    return do_allocate(bytes, alignment);
+}
@@ -0,0 +1,48 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+using namespace std;
+
+// Bump allocator for short-lived protocol state: rewind() frees everything at once while keeping
+// the chunks for the next instance. Deallocation leaves the space unused until then but drops it
+// from used(), so peak() is the most state live at once rather than all ever allocated, such as
+// the tables a growing hash map has left behind. Blocks must be freed before the rewind, if at all.
+class arena : public pmr::memory_resource
+{
+    public:
+        explicit arena(size_t chunk_size = 1 << 20) : chunk_size(chunk_size) {}
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        void rewind();
+
+        [[nodiscard]] size_t used() const { return in_use; }
+        [[nodiscard]] size_t peak() const { return high_water; }
+        [[nodiscard]] size_t reserved() const;
+        void reset_peak() { high_water = in_use; }
+
+    private:
+        struct chunk
+        {
+            unique_ptr<byte[]> data;
+            size_t size;
+        };
+
+        size_t chunk_size;
+        vector<chunk> chunks;
+        size_t current = 0;     // chunk the cursor points into
+        size_t offset = 0;      // cursor within chunks[current]
+        size_t in_use = 0;      // bytes allocated and not yet freed
+        size_t high_water = 0;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void*, size_t bytes, size_t) override { in_use -= bytes; }
+        [[nodiscard]] bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+};
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+// Nanoseconds of the steady clock since start, for the timings the runs report
+inline int64_t nanoseconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+#endif
@@ -0,0 +1,36 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "graph_io.h"
+
+using namespace std;
+
+// Converts between edge lists and binary CSR graph files: the input format is detected from the
+// file's contents, the output format from its name (binary for ".csr", an edge list otherwise)
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        cerr << "usage: " << argv[0] << " <input graph> <output graph>" << endl;
+        return 1;
+    }
+    string const in = argv[1], out = argv[2];
+    try
+    {
+        auto t1 = chrono::steady_clock::now();
+        graph g = load_graph(in);
+        auto t2 = chrono::steady_clock::now();
+        if (out.ends_with(".csr")) save_binary(g, out);
+        else save_edge_list(g, out);
+        auto t3 = chrono::steady_clock::now();
+        cout << "nodes=" << g.size() << ", edges=" << g.edges()
+             << ", load=" << chrono::duration_cast<chrono::milliseconds>(t2 - t1).count() << "ms"
+             << ", save=" << chrono::duration_cast<chrono::milliseconds>(t3 - t2).count() << "ms" << endl;
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include "cycle.h"
+
+using namespace std;
+
+uint64_t path_fingerprint(span<const int> nodes)
+{
+    uint64_t h = mix64(nodes.size());
+    for (int v : nodes) h = mix64(h ^ (uint32_t) v) + 0x9E3779B97F4A7C15ULL;
+    return h;
+}
+
+void canonical_rotation(span<const int> cycle, vector<int>& out)
+{
+    out.clear();
+    if (cycle.empty()) return;
+    size_t const k = cycle.size();
+    int const smallest = *min_element(cycle.begin(), cycle.end());
+    size_t best = k;
+    for (size_t i = 0; i < k; ++i)
+    {
+        if (cycle[i] != smallest) continue;
+        if (best == k) { best = i; continue; }
+        // A closed walk may pass its smallest node more than once; compare the two rotations
+        for (size_t j = 1; j < k; ++j)
+        {
+            int const a = cycle[(i + j) % k], c = cycle[(best + j) % k];
+            if (a != c)
+            {
+                if (a < c) best = i;
+                break;
+            }
+        }
+    }
+    out.insert(out.end(), cycle.begin() + (ptrdiff_t) best, cycle.end());
+    out.insert(out.end(), cycle.begin(), cycle.begin() + (ptrdiff_t) best);
+}
+
+bool cycle_set::insert(const path_store& paths, path_ref path)
+{
+    thread_local vector<int> nodes, canonical;
+    paths.nodes(path, nodes);
+    if (!raw_ids.insert(path_fingerprint(nodes))) return false;
+
+    span<const int> cycle(nodes);
+    if (cycle.size() > 1 && cycle.front() == cycle.back()) cycle = cycle.first(cycle.size() - 1);
+    canonical_rotation(cycle, canonical);
+    add_unique(path_fingerprint(canonical), canonical);
+    return true;
+}
+
+void cycle_set::merge(const cycle_set& other)
+{
+    other.raw_ids.for_each([&](uint64_t id) { raw_ids.insert(id); });
+    other.unique_ids.for_each([&](uint64_t id, uint32_t offset) {
+        add_unique(id, other.checked ? span<const int>(other.stored.data() + offset + 1, (size_t) other.stored[offset]) : span<const int>());
+    });
+    collision_count += other.collision_count;
+}
+
+void cycle_set::add_unique(uint64_t id, span<const int> canonical)
+{
+    auto [offset, inserted] = unique_ids.insert(id, (uint32_t) stored.size());
+    if (!checked) return;
+    if (inserted)
+    {
+        stored.push_back((int) canonical.size());
+        stored.insert(stored.end(), canonical.begin(), canonical.end());
+        return;
+    }
+    span<const int> const seen(stored.data() + *offset + 1, (size_t) stored[*offset]);
+    if (!equal(seen.begin(), seen.end(), canonical.begin(), canonical.end())) ++collision_count;
+}
@@ -0,0 +1,53 @@
+#ifndef CYCLE_H
+#define CYCLE_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "flat_hash.h"
+#include "path.h"
+
+using namespace std;
+
+// 64-bit fingerprint of a node sequence, order sensitive
+uint64_t path_fingerprint(span<const int> nodes);
+
+// Rotates the cycle, given without its closing node, so it starts at its smallest node id; of
+// several occurrences of that id the lexicographically smallest rotation wins
+void canonical_rotation(span<const int> cycle, vector<int>& out);
+
+// Distinct cycles found by a run, keyed by fingerprint instead of by formatted path. Each cycle is
+// counted twice: raw, as the path it was reported on, so rotations found from different initiators
+// differ; and unique, rotated to its smallest node first. When checked, the canonical node sequence
+// of every unique cycle is kept as well and compared on every fingerprint match, counting collisions.
+class cycle_set
+{
+    public:
+        explicit cycle_set(bool checked = false) : checked(checked) {}
+
+        // Adds a broadcast path [s, ..., s]; returns whether the path was new
+        bool insert(const path_store& paths, path_ref path);
+
+        // Adds every cycle of other, which must be checked if this set is
+        void merge(const cycle_set& other);
+
+        [[nodiscard]] size_t raw() const { return raw_ids.size(); }
+        [[nodiscard]] size_t unique() const { return unique_ids.size(); }
+        [[nodiscard]] size_t collisions() const { return collision_count; }
+        [[nodiscard]] bool is_checked() const { return checked; }
+
+        // Calls f with the fingerprint of every unique cycle
+        template<typename F>
+        void for_each_unique(F f) const { unique_ids.for_each([&](uint64_t id, uint32_t) { f(id); }); }
+
+    private:
+        bool checked;
+        flat_set<uint64_t> raw_ids;
+        flat_map<uint64_t, uint32_t> unique_ids;    // fingerprint -> offset of its cycle in stored, if checked
+        vector<int> stored;                         // length-prefixed canonical cycles
+        size_t collision_count = 0;
+
+        void add_unique(uint64_t id, span<const int> canonical);
+};
+
+#endif
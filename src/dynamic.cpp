@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "dynamic.h"
+#include "engine.h"
+#include "random.h"
+
+using namespace std;
+
+namespace
+{
+    // Removes the first occurrence of value; returns whether there was one
+    bool erase_first(vector<int>& list, int value)
+    {
+        auto it = find(list.begin(), list.end(), value);
+        if (it == list.end()) return false;
+        list.erase(it);
+        return true;
+    }
+}
+
+vector<vector<edge_update>> load_updates(const string& path)
+{
+    ifstream file(path);
+    if (!file) throw invalid_argument("cannot open update file " + path);
+    vector<vector<edge_update>> batches(1);
+    string text;
+    for (int line = 1; getline(file, text); ++line)
+    {
+        text = text.substr(0, text.find('#'));
+        istringstream fields(text);
+        string op;
+        if (!(fields >> op) || op == "commit")
+        {
+            if (!batches.back().empty()) batches.emplace_back();
+            continue;
+        }
+        edge_update update{};
+        string rest;
+        if ((op != "+" && op != "-") || !(fields >> update.e.source >> update.e.target) || fields >> rest
+            || update.e.source < 0 || update.e.target < 0)
+            throw invalid_argument(path + ":" + to_string(line) + ": expected '+ source target' or '- source target'");
+        update.insert = op == "+";
+        batches.back().push_back(update);
+    }
+    if (batches.back().empty()) batches.pop_back();
+    return batches;
+}
+
+vector<vector<edge_update>> random_updates(const graph& g, int batches, int size, uint64_t seed)
+{
+    int const n = g.size();
+    vector<vector<int>> lists(n);
+    vector<edge> edges;
+    for (int v = 0; v < n; ++v)
+        for (int w : g.neighbours(v))
+        {
+            lists[v].push_back(w);
+            edges.push_back({ v, w });
+        }
+
+    reseedThread(splitmix64(seed));
+    vector<vector<edge_update>> result(max(batches, 0));
+    for (auto &batch : result)
+    {
+        for (int i = 0; i < size && n > 1; ++i)
+        {
+            if (!edges.empty() && getRandomBelow(2) == 0)
+            {
+                size_t const k = getRandomBelow(edges.size());
+                edge const e = edges[k];
+                edges[k] = edges.back();
+                edges.pop_back();
+                erase_first(lists[e.source], e.target);
+                batch.push_back({ e, false });
+                continue;
+            }
+            auto const u = (int) getRandomBelow(n), v = (int) getRandomBelow(n);
+            if (u == v || find(lists[u].begin(), lists[u].end(), v) != lists[u].end()) continue;
+            lists[u].push_back(v);
+            edges.push_back({ u, v });
+            batch.push_back({ { u, v }, true });
+        }
+    }
+    return result;
+}
+
+dynamic_search::dynamic_search(const graph& initial, const group& G, uint64_t seed, int l, unsigned workers)
+    : l(l), out(initial.size()), in(initial.size()), topology(initial), results(initial.size())
+{
+    for (int v = 0; v < initial.size(); ++v)
+        for (int w : initial.neighbours(v))
+        {
+            out[v].push_back(w);
+            in[w].push_back(v);
+        }
+    for (unsigned w = 0; w < max(workers, 1U); ++w) replicas.push_back(make_unique<simulation>(topology, G, seed));
+}
+
+batch_stats dynamic_search::run_all(thread_pool& pool)
+{
+    vector<int> all(size());
+    for (int v = 0; v < size(); ++v) all[v] = v;
+    return run(all, pool);
+}
+
+batch_stats dynamic_search::apply(span<const edge_update> batch, thread_pool& pool)
+{
+    int const n = size();
+    for (const edge_update &u : batch)
+        if (u.e.source < 0 || u.e.source >= n || u.e.target < 0 || u.e.target >= n)
+            throw invalid_argument("update of edge (" + to_string(u.e.source) + ", " + to_string(u.e.target)
+                                   + ") outside a graph of " + to_string(n) + " nodes");
+
+    vector<char> marked(n, 0);
+    vector<int> affected, sources;
+    for (const edge_update &u : batch) if (!u.insert) sources.push_back(u.e.source);
+    mark_ball(sources, marked, affected);
+
+    batch_stats stats;
+    sources.clear();
+    for (const edge_update &u : batch)
+    {
+        auto &targets = out[u.e.source];
+        if (u.insert)
+        {
+            if (find(targets.begin(), targets.end(), u.e.target) != targets.end()) continue;
+            targets.push_back(u.e.target);
+            in[u.e.target].push_back(u.e.source);
+            sources.push_back(u.e.source);
+        }
+        else
+        {
+            if (!erase_first(targets, u.e.target)) continue;
+            erase_first(in[u.e.target], u.e.source);
+        }
+        ++stats.updates;
+    }
+    mark_ball(sources, marked, affected);
+    if (stats.updates == 0) return stats;
+
+    topology = graph(out);
+    sort(affected.begin(), affected.end());
+    batch_stats const rerun = run(affected, pool);
+    stats.reruns = rerun.reruns;
+    stats.messages = rerun.messages;
+    stats.peak_bytes = rerun.peak_bytes;
+    stats.cleanup_ns = rerun.cleanup_ns;
+    return stats;
+}
+
+void dynamic_search::mark_ball(span<const int> sources, vector<char>& marked, vector<int>& affected) const
+{
+    // Breadth-first over the reverse edges from all sources at once; seen is separate from marked,
+    // since a node marked by an earlier call may still have to be passed through
+    vector<char> seen(size(), 0);
+    vector<int> frontier, next;
+    for (int s : sources)
+        if (!seen[s])
+        {
+            seen[s] = 1;
+            frontier.push_back(s);
+        }
+    for (int hop = 0; !frontier.empty(); ++hop)
+    {
+        for (int v : frontier)
+            if (!marked[v])
+            {
+                marked[v] = 1;
+                affected.push_back(v);
+            }
+        if (hop == l - 1) break;
+        next.clear();
+        for (int v : frontier)
+            for (int u : in[v])
+                if (!seen[u])
+                {
+                    seen[u] = 1;
+                    next.push_back(u);
+                }
+        swap(frontier, next);
+    }
+}
+
+batch_stats dynamic_search::run(span<const int> initiators, thread_pool& pool)
+{
+    for (int s : initiators) add(results[s], -1);
+
+    vector<size_t> peaks(pool.size(), 0);
+    vector<int64_t> cleanup(pool.size(), 0);
+    pool.parallel_for(initiators.size(), [&](size_t i, unsigned worker) {
+        simulation &sim = *replicas[worker];
+        int const s = initiators[i];
+        run_stats one(l);
+        sim.reset();    // so the learned edges are this instance's alone
+        run_instance(sim, s, l, one);
+
+        instance_result &r = results[s];
+        r.messages = one.messages;
+        r.by_type = one.by_type;
+        r.raw_cycles = one.cycles.raw();
+        r.cycle_edges = one.cycle_edges;
+        r.cycles.clear();
+        one.cycles.for_each_unique([&](uint64_t id) { r.cycles.push_back(id); });
+        r.edges.clear();
+        sim.learned().for_each([&](uint64_t e) { r.edges.push_back(e); });
+        peaks[worker] = max(peaks[worker], sim.peak_bytes());
+        cleanup[worker] += one.cleanup_ns;
+    });
+
+    batch_stats stats;
+    stats.reruns = (int) initiators.size();
+    for (int s : initiators)
+    {
+        add(results[s], 1);
+        stats.messages += results[s].messages;
+    }
+    for (unsigned w = 0; w < pool.size(); ++w)
+    {
+        stats.peak_bytes = max(stats.peak_bytes, peaks[w]);
+        stats.cleanup_ns += cleanup[w];
+    }
+    return stats;
+}
+
+void dynamic_search::add(const instance_result& r, int sign)
+{
+    // Raw cycles start at their initiator, so instances never share one and plain sums suffice
+    raw_total += sign * (int64_t) r.raw_cycles;
+    cycle_edge_total += sign * r.cycle_edges;
+    message_total += sign * r.messages;
+    for (size_t t = 0; t < type_total.size(); ++t) type_total[t] += sign * r.by_type[t];
+    for (uint64_t id : r.cycles) sign > 0 ? cycle_refs.add(id) : cycle_refs.remove(id);
+    for (uint64_t e : r.edges) sign > 0 ? edge_refs.add(e) : edge_refs.remove(e);
+}
@@ -0,0 +1,120 @@
+#ifndef DYNAMIC_H
+#define DYNAMIC_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "flat_hash.h"
+#include "graph.h"
+#include "group.h"
+#include "node.h"
+#include "simulation.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// One change of a dynamic graph
+struct edge_update
+{
+    edge e;
+    bool insert;    // false removes the edge
+};
+
+// Update streams: one "+ source target" (insert) or "- source target" (remove) per line, '#'
+// starting a comment; a blank line or a line "commit" closes a batch. Empty batches are dropped.
+vector<vector<edge_update>> load_updates(const string& path);
+
+// Batches of size updates, about half removing edges of g and half inserting edges between random
+// nodes, as they apply in turn; reproducible from the seed
+vector<vector<edge_update>> random_updates(const graph& g, int batches, int size, uint64_t seed);
+
+// What applying one batch cost
+struct batch_stats
+{
+    int updates = 0;            // updates that changed the graph
+    int reruns = 0;             // instances run again
+    int messages = 0;           // messages they sent
+    size_t peak_bytes = 0;      // peak protocol state of one instance
+    int64_t cleanup_ns = 0;     // releasing instance state, summed over workers
+};
+
+// Keeps the result of the length-l search from every initiator while the graph changes in batches
+// of edge updates. Initiator s's instance only crosses edges (u, v) with u at most l - 1 hops from
+// s, and its random stream is fixed by (seed, l, s), so it stays the same unless a changed edge
+// starts within that radius: before the batch for a removed edge, after it for an inserted one.
+// Only those instances run again. Every instance's counts, cycle fingerprints and learned edges
+// are kept, and cycles and edges found by several instances are reference counted, so the totals
+// always equal those of a full run on the current graph.
+class dynamic_search
+{
+    public:
+        // One simulation per worker of the pool the search will run on
+        dynamic_search(const graph& initial, const group& G, uint64_t seed, int l, unsigned workers);
+
+        // Runs every instance
+        batch_stats run_all(thread_pool& pool);
+
+        // Applies the batch and runs the affected instances again. Inserting an edge already present
+        // or removing one that is not changes nothing; an id outside the graph throws invalid_argument.
+        batch_stats apply(span<const edge_update> batch, thread_pool& pool);
+
+        [[nodiscard]] const graph& current() const { return topology; }
+        [[nodiscard]] int size() const { return topology.size(); }
+
+        // Totals over all instances on the current graph
+        [[nodiscard]] size_t raw_cycles() const { return (size_t) raw_total; }
+        [[nodiscard]] size_t unique_cycles() const { return cycle_refs.live; }
+        [[nodiscard]] int cycle_edges() const { return cycle_edge_total; }
+        [[nodiscard]] int messages() const { return message_total; }
+        [[nodiscard]] const array<int, 4>& by_type() const { return type_total; }
+        [[nodiscard]] size_t known_edges() const { return edge_refs.live; }
+        // What a known_topology holding the learned edges takes, as a full run reports it; the
+        // reference counts behind them are bookkeeping of the incremental search and not counted
+        [[nodiscard]] size_t known_bytes() const { return known_topology::bytes_for(edge_refs.live); }
+
+    private:
+        // What one instance found
+        struct instance_result
+        {
+            int messages = 0;
+            array<int, 4> by_type{};
+            size_t raw_cycles = 0;
+            int cycle_edges = 0;
+            vector<uint64_t> cycles;    // unique cycle fingerprints
+            vector<uint64_t> edges;     // learned edges, packed as known_topology packs them
+        };
+
+        // Multiset of 64-bit ids; the hash map cannot erase, so ids dropping to zero stay as dead entries
+        struct ref_counts
+        {
+            flat_map<uint64_t, uint32_t> counts;
+            size_t live = 0;
+
+            void add(uint64_t id) { if ((*counts.insert(id, 0).first)++ == 0) ++live; }
+            void remove(uint64_t id) { if (--*counts.find(id) == 0) --live; }
+        };
+
+        int l;
+        vector<vector<int>> out, in;    // adjacency lists the graph is rebuilt from
+        graph topology;                 // the simulations refer to it, so it is reassigned, never replaced
+        vector<unique_ptr<simulation>> replicas;
+        vector<instance_result> results;
+
+        int64_t raw_total = 0;
+        int cycle_edge_total = 0, message_total = 0;
+        array<int, 4> type_total{};
+        ref_counts cycle_refs, edge_refs;
+
+        // Marks every node at most l - 1 hops before one of the sources and appends it to affected
+        void mark_ball(span<const int> sources, vector<char>& marked, vector<int>& affected) const;
+
+        // Runs the instances of the given initiators again, replacing their results
+        batch_stats run(span<const int> initiators, thread_pool& pool);
+
+        void add(const instance_result& r, int sign);
+};
+
+#endif
@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include "clock.h"
+#include "engine.h"
+#include "random.h"
+#include "ring_buffer.h"
+#include "timing_wheel.h"
+
+using namespace std;
+
+run_stats::run_stats(int l, const run_options& options)
+    : cycles(options.check_cycles), shortest(options.shortest > 0 ? options.shortest : l), longest(l)
+{
+    for (int k = shortest; k <= longest && shortest < longest; ++k) by_length.emplace_back(options.check_cycles);
+}
+
+void run_stats::merge(run_stats&& other)
+{
+    cycles.merge(other.cycles);
+    cycle_edges += other.cycle_edges;
+    messages += other.messages;
+    for (size_t i = 0; i < by_type.size(); ++i) by_type[i] += other.by_type[i];
+    peak_bytes = max(peak_bytes, other.peak_bytes);
+    known_edges = max(known_edges, other.known_edges);
+    known_bytes = max(known_bytes, other.known_bytes);
+    rounds = max(rounds, other.rounds);
+    cleanup_ns += other.cleanup_ns;
+    trace_decode_ns += other.trace_decode_ns;
+    transport.merge(other.transport);
+    // Every instance ran in one of the two, leaving zero in the other
+    if (other.completion_ns.size() > completion_ns.size()) completion_ns.resize(other.completion_ns.size());
+    for (size_t i = 0; i < other.completion_ns.size(); ++i) completion_ns[i] = max(completion_ns[i], other.completion_ns[i]);
+    for (size_t k = 0; k < by_length.size() && k < other.by_length.size(); ++k)
+    {
+        length_stats &to = by_length[k];
+        const length_stats &from = other.by_length[k];
+        to.messages += from.messages;
+        for (size_t i = 0; i < to.by_type.size(); ++i) to.by_type[i] += from.by_type[i];
+        to.cycles.merge(from.cycles);
+        to.cycle_edges += from.cycle_edges;
+    }
+}
+
+template<group_backend G>
+void run_stats::count(const basic_message<G>& msg, const path_store& paths)
+{
+    // Every path of an instance starts at its initiator, so a path new to the instance is new to the run
+    if (msg.valid_to >= longest)
+    {
+        ++messages;
+        by_type.at(msg.t)++;
+        if (msg.t == broadcast && cycles.insert(paths, msg.path)) cycle_edges += (int) paths.length(msg.path) - 1;
+    }
+    if (by_length.empty()) return;
+    for (int l = max<int>(msg.hop, shortest); l <= min<int>(msg.valid_to, longest); ++l)
+    {
+        length_stats &at = by_length[l - shortest];
+        ++at.messages;
+        at.by_type.at(msg.t)++;
+        if (msg.t == broadcast && at.cycles.insert(paths, msg.path)) at.cycle_edges += (int) paths.length(msg.path) - 1;
+    }
+}
+
+template<group_backend G>
+void run_instance(basic_simulation<G>& sim, int initiator, int l, run_stats& stats, trace_run *trace)
+{
+    using message = basic_message<G>;
+    thread_local ring_buffer<message> msg_queue;
+    thread_local vector<message> mailbox;
+
+    uint64_t stream = sim.seed() ^ ((uint64_t) l << 32) ^ (uint64_t) initiator;
+    reseedThread(splitmix64(stream));
+    sim.set_shortest(stats.shortest > 0 ? stats.shortest : l);
+
+    mailbox.clear();
+    sim.initiate(initiator, l, mailbox);
+    sim.carry(mailbox);
+    trace_instance *recorded = trace ? &trace->instances.at(initiator) : nullptr;
+    if (recorded) recorded->initial = (uint32_t) mailbox.size();
+    for (const auto &mm : mailbox) msg_queue.push_back(mm);
+    while (!msg_queue.empty())
+    {
+        const message &msg = msg_queue.front();
+        stats.count(msg, sim.paths());
+        mailbox.clear();
+        sim.send(msg, mailbox);
+        sim.carry(mailbox);
+        if (recorded) record(*recorded, msg, mailbox.size(), sim.paths());
+        msg_queue.pop_front();
+        for (const auto &mm : mailbox) msg_queue.push_back(mm);
+    }
+    auto t1 = chrono::steady_clock::now();
+    sim.end_instance();
+    stats.cleanup_ns += nanoseconds_since(t1);
+}
+
+template<group_backend G>
+void run_timed_instance(basic_simulation<G>& sim, int initiator, int l, const latency_model& latency, run_stats& stats)
+{
+    using message = basic_message<G>;
+    thread_local timing_wheel wheel;
+    thread_local vector<message> in_flight;     // by event id
+    thread_local vector<uint32_t> free_ids;
+    thread_local vector<message> mailbox;
+
+    uint64_t stream = sim.seed() ^ ((uint64_t) l << 32) ^ (uint64_t) initiator;
+    reseedThread(splitmix64(stream));
+    sim.set_shortest(stats.shortest > 0 ? stats.shortest : l);
+    if (stats.completion_ns.size() < (size_t) sim.size()) stats.completion_ns.resize(sim.size());
+
+    wheel.clear();
+    in_flight.clear();
+    free_ids.clear();
+    uint64_t sent = 0;
+    auto schedule = [&] {
+        for (const message &msg : mailbox)
+        {
+            uint32_t id;
+            if (free_ids.empty())
+            {
+                id = (uint32_t) in_flight.size();
+                in_flight.push_back(msg);
+            }
+            else
+            {
+                id = free_ids.back();
+                free_ids.pop_back();
+                in_flight[id] = msg;
+            }
+            // A broadcast leaves the initiator; it is charged one link's latency
+            int const source = msg.t == broadcast ? initiator : msg.source, target = msg.t == broadcast ? initiator : msg.target;
+            wheel.push(id, wheel.now() + latency.delay_ns(source, target, (uint64_t) initiator << 40 | sent++));
+        }
+    };
+
+    mailbox.clear();
+    sim.initiate(initiator, l, mailbox);
+    sim.carry(mailbox);
+    schedule();
+    uint32_t id;
+    while (wheel.pop(id))
+    {
+        message const msg = in_flight[id];     // scheduling may grow in_flight
+        free_ids.push_back(id);
+        stats.count(msg, sim.paths());
+        mailbox.clear();
+        sim.send(msg, mailbox);
+        sim.carry(mailbox);
+        schedule();
+    }
+    stats.completion_ns[initiator] = wheel.now();
+    auto t1 = chrono::steady_clock::now();
+    sim.end_instance();
+    stats.cleanup_ns += nanoseconds_since(t1);
+}
+
+template<group_backend G>
+run_stats run_serial(basic_simulation<G>& sim, int l, const run_options& options)
+{
+    run_stats stats(l, options);
+    sim.reset();
+    for (int i = 0; i < sim.size(); ++i)
+    {
+        if (options.latency) run_timed_instance(sim, i, l, *options.latency, stats);
+        else run_instance(sim, i, l, stats, options.trace);
+    }
+    stats.peak_bytes = sim.peak_bytes();
+    stats.known_edges = sim.learned().size();
+    stats.known_bytes = sim.learned().bytes();
+    stats.transport = sim.channel().stats();
+    return stats;
+}
+
+template<group_backend G>
+run_stats run_parallel(thread_pool& pool, vector<unique_ptr<basic_simulation<G>>>& replicas, int l, const run_options& options)
+{
+    vector<run_stats> partial;
+    for (unsigned w = 0; w < pool.size(); ++w) partial.emplace_back(l, options);
+    for (auto &sim : replicas) sim->reset();
+    pool.parallel_for((size_t) replicas[0]->size(), [&](size_t i, unsigned worker) {
+        if (options.latency) run_timed_instance(*replicas[worker], (int) i, l, *options.latency, partial[worker]);
+        else run_instance(*replicas[worker], (int) i, l, partial[worker], options.trace);
+    });
+
+    run_stats stats(l, options);
+    known_topology known;       // each replica learned from the instances it ran
+    for (unsigned w = 0; w < pool.size(); ++w)
+    {
+        partial[w].peak_bytes = replicas[w]->peak_bytes();
+        partial[w].transport = replicas[w]->channel().stats();
+        stats.merge(std::move(partial[w]));
+        known.merge(replicas[w]->learned());
+    }
+    stats.known_edges = known.size();
+    stats.known_bytes = known.bytes();
+    return stats;
+}
+
+template<group_backend G>
+run_stats run_rounds(thread_pool& pool, basic_simulation<G>& sim, int l, const run_options& options)
+{
+    using message = basic_message<G>;
+    run_stats stats(l, options);
+    sim.reset();
+    sim.set_shortest(stats.shortest);
+    int const n = sim.size();
+    auto const shards = (size_t) sim.shards();
+    vector<vector<message>> outbox(shards);     // per shard, so the exchange order is deterministic
+    vector<message> inbox;                      // the round's messages, grouped by target
+    vector<size_t> offsets(n + 1);              // inbox of node v is [offsets[v], offsets[v + 1])
+    vector<message> broadcasts;                 // the round's broadcasts, delivered as one batch
+
+    auto reseed = [&](int round, int v) {
+        uint64_t stream = sim.seed() ^ ((uint64_t) l << 32) ^ ((uint64_t) round << 48) ^ (uint64_t) v;
+        reseedThread(splitmix64(stream));
+    };
+
+    // Round 0: every node initiates its own instance
+    pool.parallel_for(shards, [&](size_t k, unsigned) {
+        for (int v = sim.shard_begin((int) k); v < sim.shard_begin((int) k + 1); ++v)
+        {
+            reseed(0, v);
+            sim.initiate(v, l, outbox[k]);
+        }
+    });
+
+    while (true)
+    {
+        // Bulk exchange: the round's messages cross the transport, shard by shard, then a counting
+        // sort by target; broadcasts go to everyone and are applied here
+        for (auto &out : outbox) sim.carry(out);
+        fill(offsets.begin(), offsets.end(), 0);
+        broadcasts.clear();
+        bool delivered = false;
+        for (auto &out : outbox)
+        {
+            for (const auto &msg : out)
+            {
+                stats.count(msg, sim.paths());
+                delivered = true;
+                if (msg.t != broadcast) ++offsets[msg.target + 1];
+                else broadcasts.push_back(msg);
+            }
+        }
+        sim.deliver_broadcasts(broadcasts);
+        if (!delivered) break;
+        ++stats.rounds;
+
+        for (int v = 0; v < n; ++v) offsets[v + 1] += offsets[v];
+        inbox.resize(offsets[n]);
+        vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (auto &out : outbox)
+        {
+            for (const auto &msg : out) if (msg.t != broadcast) inbox[cursor[msg.target]++] = msg;
+            out.clear();
+        }
+
+        pool.parallel_for(shards, [&](size_t k, unsigned) {
+            for (int v = sim.shard_begin((int) k); v < sim.shard_begin((int) k + 1); ++v)
+            {
+                if (offsets[v] == offsets[v + 1]) continue;
+                reseed(stats.rounds, v);
+                // Later phases first, so a publish still sees the route state the backward it follows left behind
+                for (type t : { p, b, f })
+                    for (size_t i = offsets[v]; i < offsets[v + 1]; ++i)
+                        if (inbox[i].t == t) sim.send(inbox[i], outbox[k]);
+            }
+        });
+    }
+    stats.peak_bytes = sim.peak_bytes();
+    stats.known_edges = sim.learned().size();
+    stats.known_bytes = sim.learned().bytes();
+    stats.transport = sim.channel().stats();
+    auto t1 = chrono::steady_clock::now();
+    sim.end_instance();
+    stats.cleanup_ns = nanoseconds_since(t1);
+    return stats;
+}
+
+replay_mode parse_replay_mode(const string& name)
+{
+    if (name == "handlers") return replay_mode::handlers;
+    if (name == "dispatch") return replay_mode::dispatch;
+    throw invalid_argument("replay mode must be handlers or dispatch, not " + name);
+}
+
+namespace
+{
+    // Whether a reply is the message the trace recorded in its place; paths are compared by their ends
+    template<group_backend G>
+    bool same(const basic_message<G>& a, const basic_message<G>& b, const path_store& paths)
+    {
+        return a.t == b.t && a.source == b.source && a.target == b.target && a.r == b.r && a.l == b.l && a.hop == b.hop
+            && a.valid_to == b.valid_to && G::fingerprint(a.gx) == G::fingerprint(b.gx) && paths.length(a.path) == paths.length(b.path)
+            && (a.path.empty() || (paths.front(a.path) == paths.front(b.path) && paths.back(a.path) == paths.back(b.path)));
+    }
+}
+
+template<group_backend G>
+run_stats replay(basic_simulation<G>& sim, const trace_run& run, replay_mode mode, bool check_cycles)
+{
+    using message = basic_message<G>;
+    if (sim.size() != run.topology.size() || sim.seed() != run.seed)
+        throw invalid_argument("replay: the simulation is not built from the trace's graph and seed");
+    if (mode == replay_mode::handlers && run.rng != engineName())
+        throw invalid_argument("replay: the trace was recorded with " + run.rng + ", this build draws from " + string(engineName()));
+    if (mode == replay_mode::handlers && run.master_seed != getMasterSeed())
+        throw invalid_argument("replay: the trace was recorded under master seed " + to_string(run.master_seed) + ", not " + to_string(getMasterSeed()));
+
+    run_options options;
+    options.shortest = run.shortest;
+    options.check_cycles = check_cycles;
+    run_stats stats(run.l, options);
+    sim.reset();
+    sim.set_shortest(run.shortest);
+
+    thread_local vector<message> messages;
+    thread_local vector<uint32_t> replies;
+    thread_local vector<message> mailbox;
+    thread_local ring_buffer<message> msg_queue;
+    path_store own_paths;       // dispatch decodes here, the handlers into the simulation's store
+    for (int initiator = 0; initiator < sim.size(); ++initiator)
+    {
+        const trace_instance &recorded = run.instances.at(initiator);
+        auto t0 = chrono::steady_clock::now();
+        messages.clear();
+        replies.clear();
+        own_paths.clear();
+        span<const uint8_t> in = recorded.bytes;
+        for (uint32_t i = 0; i < recorded.messages; ++i)
+        {
+            replies.push_back((uint32_t) get_varint(in));
+            messages.push_back(mode == replay_mode::handlers ? sim.decode(in) : decode<G>(in, own_paths));
+        }
+        stats.trace_decode_ns += nanoseconds_since(t0);
+        const path_store &paths = mode == replay_mode::handlers ? sim.paths() : own_paths;
+
+        if (mode == replay_mode::dispatch)
+        {
+            size_t next = recorded.initial, delivered = 0;
+            for (size_t i = 0; i < next; ++i) msg_queue.push_back(messages[i]);
+            while (!msg_queue.empty())
+            {
+                stats.count(msg_queue.front(), paths);
+                msg_queue.pop_front();
+                for (uint32_t k = 0; k < replies[delivered]; ++k) msg_queue.push_back(messages[next++]);
+                ++delivered;
+            }
+            continue;
+        }
+
+        // The first messages of the trace are what initiate() sends, and each message's replies
+        // follow all those sent before it
+        uint64_t stream = sim.seed() ^ ((uint64_t) run.l << 32) ^ (uint64_t) initiator;
+        reseedThread(splitmix64(stream));
+        size_t next = 0;
+        auto check = [&](size_t expected) {
+            if (mailbox.size() != expected || next + expected > messages.size())
+                throw runtime_error("replay: instance " + to_string(initiator) + " diverged from the trace");
+            for (const message &reply : mailbox)
+                if (!same(reply, messages[next++], paths)) throw runtime_error("replay: instance " + to_string(initiator) + " diverged from the trace");
+        };
+        mailbox.clear();
+        sim.initiate(initiator, run.l, mailbox);
+        check(recorded.initial);
+        for (size_t i = 0; i < messages.size(); ++i)
+        {
+            stats.count(messages[i], paths);
+            mailbox.clear();
+            sim.send(messages[i], mailbox);
+            check(replies[i]);
+        }
+        auto t1 = chrono::steady_clock::now();
+        sim.end_instance();
+        stats.cleanup_ns += nanoseconds_since(t1);
+    }
+    stats.peak_bytes = sim.peak_bytes();
+    stats.known_edges = sim.learned().size();
+    stats.known_bytes = sim.learned().bytes();
+    return stats;
+}
+
+template void run_stats::count(const basic_message<small_group>&, const path_store&);
+template void run_instance(basic_simulation<small_group>&, int, int, run_stats&, trace_run *);
+template void run_timed_instance(basic_simulation<small_group>&, int, int, const latency_model&, run_stats&);
+template run_stats run_serial(basic_simulation<small_group>&, int, const run_options&);
+template run_stats run_parallel(thread_pool&, vector<unique_ptr<basic_simulation<small_group>>>&, int, const run_options&);
+template run_stats run_rounds(thread_pool&, basic_simulation<small_group>&, int, const run_options&);
+template run_stats replay(basic_simulation<small_group>&, const trace_run&, replay_mode, bool);
+
+template void run_stats::count(const basic_message<group>&, const path_store&);
+template void run_instance(basic_simulation<group>&, int, int, run_stats&, trace_run *);
+template void run_timed_instance(basic_simulation<group>&, int, int, const latency_model&, run_stats&);
+template run_stats run_serial(basic_simulation<group>&, int, const run_options&);
+template run_stats run_parallel(thread_pool&, vector<unique_ptr<basic_simulation<group>>>&, int, const run_options&);
+template run_stats run_rounds(thread_pool&, basic_simulation<group>&, int, const run_options&);
+template run_stats replay(basic_simulation<group>&, const trace_run&, replay_mode, bool);
+
+template void run_stats::count(const basic_message<modp2048>&, const path_store&);
+template void run_instance(basic_simulation<modp2048>&, int, int, run_stats&, trace_run *);
+template void run_timed_instance(basic_simulation<modp2048>&, int, int, const latency_model&, run_stats&);
+template run_stats run_serial(basic_simulation<modp2048>&, int, const run_options&);
+template run_stats run_parallel(thread_pool&, vector<unique_ptr<basic_simulation<modp2048>>>&, int, const run_options&);
+template run_stats run_rounds(thread_pool&, basic_simulation<modp2048>&, int, const run_options&);
+template run_stats replay(basic_simulation<modp2048>&, const trace_run&, replay_mode, bool);
+
+template void run_stats::count(const basic_message<modp3072>&, const path_store&);
+template void run_instance(basic_simulation<modp3072>&, int, int, run_stats&, trace_run *);
+template void run_timed_instance(basic_simulation<modp3072>&, int, int, const latency_model&, run_stats&);
+template run_stats run_serial(basic_simulation<modp3072>&, int, const run_options&);
+template run_stats run_parallel(thread_pool&, vector<unique_ptr<basic_simulation<modp3072>>>&, int, const run_options&);
+template run_stats run_rounds(thread_pool&, basic_simulation<modp3072>&, int, const run_options&);
+template run_stats replay(basic_simulation<modp3072>&, const trace_run&, replay_mode, bool);
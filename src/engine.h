@@ -0,0 +1,115 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cycle.h"
+#include "latency.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+using namespace std;
+
+// How a run is counted. A flood of length l carries every message a search of any shorter length
+// l' sends, those descending from forwards at most l' hops out, along with what shorter searches
+// never send. With shortest below l, one flood stands in for all lengths from shortest to l.
+struct run_options
+{
+    int shortest = 0;               // 0 for just the run's own length
+    bool check_cycles = false;      // store cycles as well as fingerprints and count collisions
+    const latency_model *latency = nullptr;     // deliver by simulated arrival time instead of in order sent
+    trace_run *trace = nullptr;                 // record every instance's messages, fifo engine only
+};
+
+// What a search of one length sent and found, as counted from a longer flood
+struct length_stats
+{
+    int messages = 0;
+    array<int, 4> by_type{};
+    cycle_set cycles;
+    int cycle_edges = 0;
+
+    explicit length_stats(bool check_cycles = false) : cycles(check_cycles) {}
+};
+
+// Counters of one run, summed over its instances
+struct run_stats
+{
+    cycle_set cycles;                   // distinct cycles over all instances, raw and rotation-unique
+    int cycle_edges = 0;                // edges of the raw cycles
+    int messages = 0;
+    array<int, 4> by_type{};            // messages per type
+    size_t peak_bytes = 0;              // peak protocol state held by one simulation
+    size_t known_edges = 0;             // distinct edges learned from the broadcasts
+    size_t known_bytes = 0;             // held by the shared set of learned edges
+    int rounds = 0;                     // synchronous rounds to completion, round engine only
+    int64_t cleanup_ns = 0;             // releasing instance state, summed over workers
+    int64_t trace_decode_ns = 0;        // decoding the trace before delivery, replays only
+    transport_stats transport;          // traffic through the simulations' transports
+    vector<uint64_t> completion_ns;     // by initiator, simulated time its instance took; timed runs only
+    int shortest = 0, longest = 0;      // search lengths counted; 0 counts every message
+    vector<length_stats> by_length;     // lengths shortest..longest, when there is more than one
+
+    explicit run_stats(int l = 0, const run_options& options = {});
+
+    void merge(run_stats&& other);
+
+    // Counts a delivered message, and the cycle a broadcast reports, for every length that sends it
+    template<group_backend G>
+    void count(const basic_message<G>& msg, const path_store& paths);
+
+    [[nodiscard]] const length_stats& at_length(int l) const { return by_length.at(l - shortest); }
+};
+
+// Floods the instance started by initiator and adds its messages and cycles to stats. The
+// thread's random stream is reseeded from (sim seed, l, initiator) first, so an instance
+// produces the same messages no matter which thread or replica runs it. Stale publish links are
+// followed for the lengths stats counts from stats.shortest, or just l. With a trace, the delivered
+// messages go into the initiator's slot of it.
+template<group_backend G>
+void run_instance(basic_simulation<G>& sim, int initiator, int l, run_stats& stats, trace_run *trace = nullptr);
+
+// Like run_instance, but every message arrives after the latency its edge and jitter give it, in a
+// discrete-event simulation: messages wait in a timing wheel, handlers take no time, and the
+// instance's completion time, that of its last arrival, goes into stats.completion_ns.
+template<group_backend G>
+void run_timed_instance(basic_simulation<G>& sim, int initiator, int l, const latency_model& latency, run_stats& stats);
+
+// Runs every initiator's instance in order on the calling thread, timed if options.latency is set
+template<group_backend G>
+run_stats run_serial(basic_simulation<G>& sim, int l, const run_options& options = {});
+
+// Runs the instances concurrently on the pool, worker w using replicas[w]; the replicas must
+// be built from the same graph, group and seed. The merged result equals run_serial's. Timed
+// instances do not interact, so running them apart equals starting them all at once.
+template<group_backend G>
+run_stats run_parallel(thread_pool& pool, vector<unique_ptr<basic_simulation<G>>>& replicas, int l, const run_options& options = {});
+
+// Runs all instances at once in synchronous rounds. Every node has an inbox: the messages sent
+// in one round are exchanged in bulk, sorted by target into one CSR array, and delivered in the
+// next round, in which the simulation's shards process their inboxes in parallel on the pool.
+// Random streams are reseeded per (round, node), so results do not depend on the thread count.
+template<group_backend G>
+run_stats run_rounds(thread_pool& pool, basic_simulation<G>& sim, int l, const run_options& options = {});
+
+enum class replay_mode : uint8_t { handlers, dispatch };
+
+// Throws invalid_argument unless the name is handlers or dispatch
+replay_mode parse_replay_mode(const string& name);
+
+// Replays a traced fifo run on sim, which must be built from the run's graph, group and seed; the
+// handlers also need the run's master seed and generator. Each instance's messages are decoded
+// first, and the time that takes goes into stats.trace_decode_ns.
+// With handlers, every instance is reseeded as it was and its messages are handed to their nodes in
+// the recorded order, so the nodes redo the recorded work with no queue and no transport; the
+// replies must match the trace, or runtime_error is thrown. With dispatch, the messages only pass
+// through the fifo engine's queue and are counted: the engine's own overhead. Either way the
+// counts equal the recorded run's.
+template<group_backend G>
+run_stats replay(basic_simulation<G>& sim, const trace_run& run, replay_mode mode, bool check_cycles = false);
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef FLAT_HASH_H
+#define FLAT_HASH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// 64-bit finaliser from MurmurHash3, spreads clustered keys over the whole table
+inline uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB93FE53A85A1ULL;
+    return x ^ (x >> 33);
+}
+
+template <typename K> struct flat_hash;
+
+template <> struct flat_hash<uint64_t>
+{
+    uint64_t operator()(uint64_t k) const { return mix64(k); }
+};
+
+template <> struct flat_hash<pair<uint64_t, uint64_t>>
+{
+    uint64_t operator()(const pair<uint64_t, uint64_t>& k) const { return mix64(k.first ^ mix64(k.second)); }
+};
+
+struct flat_empty {};
+
+// Open-addressing hash map with linear probing and a power-of-two table; never overwrites on insert
+template <typename K, typename V, typename Hash = flat_hash<K>>
+class flat_map
+{
+    public:
+        explicit flat_map(pmr::memory_resource *mem = pmr::get_default_resource()) : slots(mem), used(mem) {}
+
+        [[nodiscard]] size_t size() const { return count; }
+        [[nodiscard]] bool empty() const { return count == 0; }
+        [[nodiscard]] size_t bytes() const { return slots.capacity() * sizeof(slot) + used.capacity(); }
+
+        // bytes() of a map that n distinct keys were inserted into
+        [[nodiscard]] static size_t bytes_for(size_t n)
+        {
+            size_t capacity = 0;
+            while (n * 4 > capacity * 3) capacity = max<size_t>(16, capacity * 2);
+            return capacity * (sizeof(slot) + 1);
+        }
+
+        V* find(const K& key)
+        {
+            if (count == 0) return nullptr;
+            for (size_t i = Hash{}(key) & mask;; i = (i + 1) & mask)
+            {
+                if (!used[i]) return nullptr;
+                if (slots[i].key == key) return &slots[i].value;
+            }
+        }
+
+        const V* find(const K& key) const { return const_cast<flat_map*>(this)->find(key); }
+
+        bool contains(const K& key) const { return find(key) != nullptr; }
+
+        // Inserts key -> value unless key is present; returns the stored value and whether it was inserted
+        pair<V*, bool> insert(const K& key, const V& value = V{})
+        {
+            if ((count + 1) * 4 > slots.size() * 3) grow();
+            for (size_t i = Hash{}(key) & mask;; i = (i + 1) & mask)
+            {
+                if (!used[i])
+                {
+                    used[i] = 1;
+                    slots[i] = { key, value };
+                    ++count;
+                    return { &slots[i].value, true };
+                }
+                if (slots[i].key == key) return { &slots[i].value, false };
+            }
+        }
+
+        void clear()
+        {
+            slots.clear();
+            used.clear();
+            count = 0;
+            mask = 0;
+        }
+
+        template <typename F>
+        void for_each(F f) const
+        {
+            for (size_t i = 0; i < slots.size(); ++i) if (used[i]) f(slots[i].key, slots[i].value);
+        }
+
+    private:
+        struct slot
+        {
+            K key;
+            [[no_unique_address]] V value;
+        };
+
+        pmr::vector<slot> slots;
+        pmr::vector<uint8_t> used;
+        size_t count = 0;
+        size_t mask = 0;
+
+        void grow()
+        {
+            pmr::vector<slot> old_slots(slots.get_allocator());
+            pmr::vector<uint8_t> old_used(used.get_allocator());
+            old_slots.swap(slots);
+            old_used.swap(used);
+            size_t const capacity = max<size_t>(16, old_slots.size() * 2);
+            slots.assign(capacity, slot{});
+            used.assign(capacity, 0);
+            mask = capacity - 1;
+            count = 0;
+            for (size_t i = 0; i < old_slots.size(); ++i)
+                if (old_used[i]) insert(old_slots[i].key, old_slots[i].value);
+        }
+};
+
+template <typename K, typename Hash = flat_hash<K>>
+class flat_set
+{
+    public:
+        explicit flat_set(pmr::memory_resource *mem = pmr::get_default_resource()) : map(mem) {}
+
+        [[nodiscard]] size_t size() const { return map.size(); }
+        [[nodiscard]] size_t bytes() const { return map.bytes(); }
+        [[nodiscard]] static size_t bytes_for(size_t n) { return flat_map<K, flat_empty, Hash>::bytes_for(n); }
+        [[nodiscard]] bool contains(const K& key) const { return map.contains(key); }
+        bool insert(const K& key) { return map.insert(key).second; }
+        void clear() { map.clear(); }
+
+        template <typename F>
+        void for_each(F f) const { map.for_each([&](const K& key, flat_empty) { f(key); }); }
+
+    private:
+        flat_map<K, flat_empty, Hash> map;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include <stdexcept>
+#include <utility>
+#include "graph.h"
+
+using namespace std;
+
+namespace
+{
+    struct csr_arrays
+    {
+        vector<size_t> offsets;
+        vector<int> targets;
+    };
+}
+
+graph::graph() : graph(vector<size_t>{ 0 }, {}) {}
+
+graph::graph(vector<size_t> offsets, vector<int> targets)
+{
+    adopt(std::move(offsets), std::move(targets));
+}
+
+graph::graph(const vector<vector<int>>& lists)
+{
+    vector<size_t> offsets;
+    offsets.reserve(lists.size() + 1);
+    offsets.push_back(0);
+    for (const auto &list : lists) offsets.push_back(offsets.back() + list.size());
+    vector<int> targets;
+    targets.reserve(offsets.back());
+    for (const auto &list : lists) targets.insert(targets.end(), list.begin(), list.end());
+    adopt(std::move(offsets), std::move(targets));
+}
+
+graph::graph(int n, span<const edge> edges)
+{
+    vector<size_t> offsets(n + 1, 0);
+    vector<int> targets(edges.size());
+    for (const edge &e : edges) ++offsets[e.source + 1];
+    for (int v = 0; v < n; ++v) offsets[v + 1] += offsets[v];
+    vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (const edge &e : edges) targets[cursor[e.source]++] = e.target;
+    adopt(std::move(offsets), std::move(targets));
+}
+
+graph::graph(shared_ptr<const void> owner, span<const size_t> offsets, span<const int> targets)
+    : owner(std::move(owner)), offsets(offsets), targets(targets)
+{
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != targets.size())
+        throw invalid_argument("graph: offsets do not describe the targets");
+}
+
+void graph::adopt(vector<size_t> offsets, vector<int> targets)
+{
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != targets.size())
+        throw invalid_argument("graph: offsets do not describe the targets");
+    auto arrays = make_shared<csr_arrays>(csr_arrays{ std::move(offsets), std::move(targets) });
+    this->offsets = arrays->offsets;
+    this->targets = arrays->targets;
+    owner = std::move(arrays);
+}
@@ -0,0 +1,54 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+using namespace std;
+
+struct edge
+{
+    int source;
+    int target;
+};
+
+// Directed graph in compressed sparse row form: the out-neighbours of node v are
+// targets[offsets[v], offsets[v + 1]), in the order the edges were added. The arrays are immutable
+// and shared by copies; they live either in vectors the graph owns or in a mapped graph file.
+class graph
+{
+    public:
+        graph();
+        graph(vector<size_t> offsets, vector<int> targets);
+
+        // Adjacency lists; list v holds the out-neighbours of node v
+        explicit graph(const vector<vector<int>>& lists);
+
+        // Edge list over nodes [0, n); a stable counting sort by source keeps the edge order per node
+        graph(int n, span<const edge> edges);
+
+        // Arrays held elsewhere, e.g. in a file mapping, that owner keeps alive; they are not copied
+        graph(shared_ptr<const void> owner, span<const size_t> offsets, span<const int> targets);
+
+        [[nodiscard]] int size() const { return (int) offsets.size() - 1; }
+        [[nodiscard]] size_t edges() const { return targets.size(); }
+        [[nodiscard]] size_t degree(int v) const { return offsets[v + 1] - offsets[v]; }
+        [[nodiscard]] span<const int> neighbours(int v) const { return targets.subspan(offsets[v], degree(v)); }
+
+        [[nodiscard]] span<const size_t> row_offsets() const { return offsets; }
+        [[nodiscard]] span<const int> column_targets() const { return targets; }
+
+        // Bytes of the two arrays
+        [[nodiscard]] size_t bytes() const { return offsets.size_bytes() + targets.size_bytes(); }
+
+    private:
+        shared_ptr<const void> owner;
+        span<const size_t> offsets;
+        span<const int> targets;
+
+        void adopt(vector<size_t> offsets, vector<int> targets);
+};
+
+#endif
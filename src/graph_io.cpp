@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "flat_hash.h"
+#include "graph_io.h"
+
+using namespace std;
+
+namespace
+{
+    constexpr char magic[8] = { 'C', 'Y', 'C', 'L', 'E', 'C', 'S', 'R' };
+    constexpr uint32_t version = 1;
+    constexpr uint32_t byte_order = 0x01020304;     // reads back differently on a host of the other endianness
+
+    struct file_header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t nodes;
+        uint64_t edges;
+    };
+    static_assert(sizeof(file_header) == 32, "the offsets must start 8-byte aligned");
+    static_assert(sizeof(size_t) == sizeof(uint64_t), "offsets are stored as 64-bit integers");
+
+    constexpr size_t block_size = 1 << 20;
+
+    // A read-only mapping of a whole file, unmapped when the last graph using it goes away
+    struct mapping
+    {
+        void *data = MAP_FAILED;
+        size_t length = 0;
+
+        ~mapping() { if (data != MAP_FAILED) munmap(data, length); }
+    };
+
+    bool is_blank(char c) { return c == ' ' || c == '\t' || c == ',' || c == '\r'; }
+
+    // Parses the leading id of [p, end) and advances p past it; false if there is none
+    bool parse_id(const char *&p, const char *end, int& id)
+    {
+        while (p < end && is_blank(*p)) ++p;
+        auto [next, ec] = from_chars(p, end, id);
+        if (ec != errc() || id < 0) return false;
+        p = next;
+        return true;
+    }
+}
+
+graph load_edge_list(const string& path)
+{
+    unique_ptr<FILE, int (*)(FILE *)> file(fopen(path.c_str(), "rb"), fclose);
+    if (!file) throw runtime_error("load_edge_list: cannot open " + path);
+
+    vector<edge> edges;
+    flat_set<uint64_t> seen;    // packed (source, target) of the edges kept
+    int n = 0;
+    size_t line = 0;
+    auto parse_line = [&](const char *p, const char *end) {
+        ++line;
+        while (p < end && is_blank(*p)) ++p;
+        if (p == end || *p == '#' || *p == '%') return;
+        edge e{};
+        if (!parse_id(p, end, e.source) || !parse_id(p, end, e.target) || e.source == INT_MAX || e.target == INT_MAX)
+            throw runtime_error("load_edge_list: bad edge on line " + to_string(line) + " of " + path);
+        n = max({ n, e.source + 1, e.target + 1 });
+        // Any further columns, such as weights, are ignored; so are self-loops and repeated edges
+        if (e.source == e.target || !seen.insert((uint64_t) e.source << 32 | (uint32_t) e.target)) return;
+        edges.push_back(e);
+    };
+
+    // Complete lines are parsed straight from the block; a line cut off at its end moves to the front
+    vector<char> buffer(block_size);
+    size_t kept = 0;
+    while (true)
+    {
+        size_t const got = fread(buffer.data() + kept, 1, buffer.size() - kept, file.get());
+        size_t const filled = kept + got;
+        const char *begin = buffer.data();
+        const char *const end = begin + filled;
+        for (const char *nl; (nl = (const char *) memchr(begin, '\n', end - begin)) != nullptr; begin = nl + 1)
+            parse_line(begin, nl);
+        kept = end - begin;
+        if (got == 0)
+        {
+            if (kept > 0) parse_line(begin, end);
+            break;
+        }
+        if (kept == buffer.size()) throw runtime_error("load_edge_list: line " + to_string(line + 1) + " of " + path + " is too long");
+        memmove(buffer.data(), begin, kept);
+    }
+    if (ferror(file.get())) throw runtime_error("load_edge_list: cannot read " + path);
+    return { n, edges };
+}
+
+void save_edge_list(const graph& g, const string& path)
+{
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file) throw runtime_error("save_edge_list: cannot create " + path);
+    vector<char> buffer;
+    buffer.reserve(block_size + 32);
+    char id[16];
+    for (int v = 0; v < g.size(); ++v)
+    {
+        for (int target : g.neighbours(v))
+        {
+            buffer.insert(buffer.end(), id, to_chars(id, id + sizeof(id), v).ptr);
+            buffer.push_back(' ');
+            buffer.insert(buffer.end(), id, to_chars(id, id + sizeof(id), target).ptr);
+            buffer.push_back('\n');
+            if (buffer.size() >= block_size)
+            {
+                file.write(buffer.data(), (streamsize) buffer.size());
+                buffer.clear();
+            }
+        }
+    }
+    file.write(buffer.data(), (streamsize) buffer.size());
+    if (!file) throw runtime_error("save_edge_list: cannot write " + path);
+}
+
+graph map_binary(const string& path)
+{
+    int const fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("map_binary: cannot open " + path);
+    struct stat info{};
+    auto map = make_shared<mapping>();
+    if (fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(file_header))
+    {
+        map->length = info.st_size;
+        map->data = mmap(nullptr, map->length, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map->data == MAP_FAILED) throw runtime_error("map_binary: cannot map " + path);
+
+    file_header header{};
+    memcpy(&header, map->data, sizeof(header));
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.byte_order != byte_order)
+        throw runtime_error("map_binary: " + path + " is not a graph file of this version and byte order");
+    if (header.nodes >= INT_MAX || header.edges > (map->length - sizeof(header)) / sizeof(int)
+        || map->length != sizeof(header) + (header.nodes + 1) * sizeof(uint64_t) + header.edges * sizeof(int))
+        throw runtime_error("map_binary: " + path + " is truncated or has a bad header");
+
+    auto const *offsets = (const size_t *) ((const char *) map->data + sizeof(header));
+    auto const *targets = (const int *) (offsets + header.nodes + 1);
+    // The arrays are used unchecked from then on, so a corrupt file must not get that far
+    bool valid = offsets[0] == 0 && offsets[header.nodes] == header.edges;
+    for (uint64_t v = 0; valid && v < header.nodes; ++v) valid = offsets[v] <= offsets[v + 1];
+    for (uint64_t e = 0; valid && e < header.edges; ++e) valid = targets[e] >= 0 && (uint64_t) targets[e] < header.nodes;
+    if (!valid) throw runtime_error("map_binary: " + path + " has offsets or targets outside the graph");
+    return { map, { offsets, header.nodes + 1 }, { targets, header.edges } };
+}
+
+void save_binary(const graph& g, const string& path)
+{
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file) throw runtime_error("save_binary: cannot create " + path);
+    file_header header{};
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byte_order = byte_order;
+    header.nodes = g.size();
+    header.edges = g.edges();
+    file.write((const char *) &header, sizeof(header));
+    file.write((const char *) g.row_offsets().data(), (streamsize) g.row_offsets().size_bytes());
+    file.write((const char *) g.column_targets().data(), (streamsize) g.column_targets().size_bytes());
+    if (!file) throw runtime_error("save_binary: cannot write " + path);
+}
+
+graph load_graph(const string& path)
+{
+    char head[sizeof(magic)] = {};
+    ifstream file(path, ios::binary);
+    if (!file) throw runtime_error("load_graph: cannot open " + path);
+    file.read(head, sizeof(head));
+    bool const binary = file.gcount() == sizeof(head) && memcmp(head, magic, sizeof(magic)) == 0;
+    file.close();
+    return binary ? map_binary(path) : load_edge_list(path);
+}
@@ -0,0 +1,28 @@
+#ifndef GRAPH_IO_H
+#define GRAPH_IO_H
+
+#include <string>
+#include "graph.h"
+
+using namespace std;
+
+// Plain edge lists: one "source target" pair of non-negative ids per line, separated by blanks or
+// commas; lines starting with '#' or '%' are comments. Ids are used as they are, so the graph has
+// max id + 1 nodes. Self-loops and repeats of an edge already read are dropped, as the generators
+// never produce them and a length-1 cycle is not one. The file is parsed in fixed-size blocks and
+// never held in memory as text.
+graph load_edge_list(const string& path);
+void save_edge_list(const graph& g, const string& path);
+
+// Binary CSR files: a 32-byte header (magic, version, node count, edge count) followed by the
+// offsets as 64-bit and the targets as 32-bit integers, in host byte order. map_binary maps the
+// file read-only and the graph uses the mapped arrays directly, once it has checked that the offsets
+// start at 0, never decrease and end at the edge count, and that every target is a node; a file
+// failing any of these throws runtime_error.
+graph map_binary(const string& path);
+void save_binary(const graph& g, const string& path);
+
+// Maps the file if it starts with the binary magic, parses it as an edge list otherwise
+graph load_graph(const string& path);
+
+#endif
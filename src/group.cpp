@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include "group.h"
+#include "util.h"
+
+using namespace std;
+
+fixed_base_table::fixed_base_table(const montgomery& mont, uint64_t base, int bits)
+{
+    int const rows = (bits + window - 1) / window;
+    table.resize((size_t) rows << window);
+    uint64_t b = base;
+    for (int i = 0; i < rows; ++i)
+    {
+        uint64_t *row = &table[(size_t) i << window];
+        row[0] = mont.one();
+        for (int j = 1; j < (1 << window); ++j) row[j] = mont.mul(row[j - 1], b);
+        b = mont.mul(row[(1 << window) - 1], b);
+    }
+}
+
+uint64_t fixed_base_table::pow(const montgomery& mont, uint64_t e) const
+{
+    uint64_t x = mont.one();
+    for (size_t row = 0; e != 0; ++row, e >>= window)
+    {
+        uint64_t const digit = e & ((1 << window) - 1);
+        if (digit) x = mont.mul(x, table[(row << window) | digit]);
+    }
+    return x;
+}
+
+uint64_t group::pow_g(uint64_t e) const
+{
+    PROFILE_SCOPE(probe::pow_g);
+    if (!g_table) return pow(g, e);
+    call_once(g_table->built, [this] {
+        g_table->table = make_unique<fixed_base_table>(mont, mont.to(g), 64 - countl_zero(q));
+    });
+    // g has order q, so reducing the exponent keeps it within the table
+    return mont.from(g_table->table->pow(mont, e % q));
+}
+
+void group::pow_batch(span<const uint64_t> bases, span<const uint64_t> exps, span<uint64_t> out) const
+{
+    PROFILE_SCOPE(probe::pow_batch);
+    PROFILE_COUNT(tally::pow_lanes, out.size());
+    uint64_t reduced[64];
+    for (size_t i = 0; i < out.size(); i += size(reduced))
+    {
+        size_t const n = min(out.size() - i, size(reduced));
+        for (size_t j = 0; j < n; ++j) reduced[j] = exps[i + j] % q;
+        batch(bases.subspan(i, n), span(reduced, n), out.subspan(i, n));
+    }
+}
+
+void group::random(span<uint64_t> out) const
+{
+    fillRandomInGroup(*this, out);
+}
+
+small_group::small_group(const group& G) : p(G.p), q(G.q), r(G.r), h(G.h), g(G.g)
+{
+    if (p >> 32) throw invalid_argument("small group needs p < 2^32");
+}
+
+uint64_t small_group::pow(uint64_t a, uint64_t e) const
+{
+    PROFILE_SCOPE(probe::pow);
+    uint64_t x = 1 % p;
+    a %= p;
+    for (; e > 0; e >>= 1)
+    {
+        if (e & 1) x = x * a % p;
+        a = a * a % p;
+    }
+    return x;
+}
+
+void small_group::pow_batch(span<const uint64_t> bases, span<const uint64_t> exps, span<uint64_t> out) const
+{
+    PROFILE_SCOPE(probe::pow_batch);
+    PROFILE_COUNT(tally::pow_lanes, out.size());
+    for (size_t i = 0; i < out.size(); ++i) out[i] = pow(bases[i], exps[i] % q);
+}
+
+void small_group::random(span<uint64_t> out) const
+{
+    {
+        PROFILE_SCOPE(probe::random);
+        PROFILE_COUNT(tally::random_draws, out.size());
+        fillRandomBelow(q, out);
+    }
+    for (auto &v : out) v = pow_g(v);
+}
+
+const char *modp_prime_hex(int bits)
+{
+    // RFC 3526 groups 14 and 15: p = 2^n - 2^(n-64) - 1 + 2^64 * (floor(2^(n-130) pi) + c)
+    if (bits == 2048)
+        return "FFFFFFFF FFFFFFFF C90FDAA2 2168C234 C4C6628B 80DC1CD1 29024E08 8A67CC74"
+               "020BBEA6 3B139B22 514A0879 8E3404DD EF9519B3 CD3A431B 302B0A6D F25F1437"
+               "4FE1356D 6D51C245 E485B576 625E7EC6 F44C42E9 A637ED6B 0BFF5CB6 F406B7ED"
+               "EE386BFB 5A899FA5 AE9F2411 7C4B1FE6 49286651 ECE45B3D C2007CB8 A163BF05"
+               "98DA4836 1C55D39A 69163FA8 FD24CF5F 83655D23 DCA3AD96 1C62F356 208552BB"
+               "9ED52907 7096966D 670C354E 4ABC9804 F1746C08 CA18217C 32905E46 2E36CE3B"
+               "E39E772C 180E8603 9B2783A2 EC07A28F B5C55DF0 6F4C52C9 DE2BCBF6 95581718"
+               "3995497C EA956AE5 15D22618 98FA0510 15728E5A 8AACAA68 FFFFFFFF FFFFFFFF";
+    if (bits == 3072)
+        return "FFFFFFFF FFFFFFFF C90FDAA2 2168C234 C4C6628B 80DC1CD1 29024E08 8A67CC74"
+               "020BBEA6 3B139B22 514A0879 8E3404DD EF9519B3 CD3A431B 302B0A6D F25F1437"
+               "4FE1356D 6D51C245 E485B576 625E7EC6 F44C42E9 A637ED6B 0BFF5CB6 F406B7ED"
+               "EE386BFB 5A899FA5 AE9F2411 7C4B1FE6 49286651 ECE45B3D C2007CB8 A163BF05"
+               "98DA4836 1C55D39A 69163FA8 FD24CF5F 83655D23 DCA3AD96 1C62F356 208552BB"
+               "9ED52907 7096966D 670C354E 4ABC9804 F1746C08 CA18217C 32905E46 2E36CE3B"
+               "E39E772C 180E8603 9B2783A2 EC07A28F B5C55DF0 6F4C52C9 DE2BCBF6 95581718"
+               "3995497C EA956AE5 15D22618 98FA0510 15728E5A 8AAAC42D AD33170D 04507A33"
+               "A85521AB DF1CBA64 ECFB8504 58DBEF0A 8AEA7157 5D060C7D B3970F85 A6E1E4C7"
+               "ABF5AE8C DB0933D7 1E8C94E0 4A25619D CEE3D226 1AD2EE6B F12FFA06 D98A0864"
+               "D8760273 3EC86A64 521F2B18 177B200C BBE11757 7A615D6C 770988C0 BAD946E2"
+               "08E24FA0 74E5AB31 43DB5BFC E0FD108E 4B82D120 A93AD2CA FFFFFFFF FFFFFFFF";
+    throw invalid_argument("no MODP group of " + to_string(bits) + " bits");
+}
+
+group_kind parse_group_kind(const string& name)
+{
+    for (auto kind : { group_kind::small, group_kind::montgomery64, group_kind::modp2048, group_kind::modp3072 })
+        if (name == group_name(kind)) return kind;
+    throw invalid_argument("group must be small, mont64, modp2048 or modp3072, not " + name);
+}
+
+const char *group_name(group_kind kind)
+{
+    switch (kind)
+    {
+        case group_kind::small: return "small";
+        case group_kind::modp2048: return "modp2048";
+        case group_kind::modp3072: return "modp3072";
+        default: return "mont64";
+    }
+}
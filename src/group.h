@@ -0,0 +1,230 @@
+#ifndef GROUP_H
+#define GROUP_H
+
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "modarith.h"
+#include "multiprecision.h"
+#include "powbatch.h"
+#include "profile.h"
+#include "random.h"
+
+using namespace std;
+
+// What the protocol needs of a group: fixed-size elements and exponents, multiplication,
+// exponentiation of one base or many, powers of the generator, uniform 64-bit draws for nonces and
+// the exponent exponent_draws of them stand for, and a 64-bit fingerprint by which elements are
+// hashed and indexed.
+// Nodes, messages and engines are templates over it, so each backend gets its own compiled code.
+template<typename G>
+concept group_backend = requires(const G& grp, const typename G::element& x, const typename G::exponent& e,
+                                 span<const typename G::element> xs, span<const typename G::exponent> es,
+                                 span<typename G::element> out, span<uint64_t> draws)
+{
+    requires is_trivially_copyable_v<typename G::element> && is_trivially_copyable_v<typename G::exponent>;
+    { grp.mul(x, x) } -> same_as<typename G::element>;
+    { grp.pow(x, e) } -> same_as<typename G::element>;
+    { grp.pow_g(e) } -> same_as<typename G::element>;
+    grp.pow_batch(xs, es, out);
+    grp.random(draws);
+    { G::exponent_draws } -> convertible_to<size_t>;
+    { grp.to_exponent(draws) } -> same_as<typename G::exponent>;
+    { G::fingerprint(x) } -> same_as<uint64_t>;
+};
+
+// Windowed fixed-base table for one base b: entry [i][j] holds b^(j * 2^(8i)) in Montgomery form
+class fixed_base_table
+{
+    public:
+        static constexpr int window = 8;
+
+        fixed_base_table(const montgomery& mont, uint64_t base, int bits);
+
+        // b^e in Montgomery form for e < 2^bits, one multiplication per non-zero window
+        [[nodiscard]] uint64_t pow(const montgomery& mont, uint64_t e) const;
+
+    private:
+        vector<uint64_t> table;
+};
+
+// Order-q subgroup of Z_p^* generated by g = h^r, with p = q*r + 1 prime and p < 2^62, in 64-bit
+// Montgomery arithmetic. The default backend: elements and exponents are single words.
+struct group
+{
+    using element = uint64_t;
+    using exponent = uint64_t;
+
+    uint64_t p{}, q{}, r{}, h{}, g{};
+    montgomery mont;        // precomputed constants for arithmetic modulo p
+    pow_batcher batch;      // batched exponentiation kernel chosen for p on this CPU
+
+    group() = default;
+    group(uint64_t p, uint64_t q, uint64_t r, uint64_t h, uint64_t g)
+        : p(p), q(q), r(r), h(h), g(g), mont(p), batch(p), g_table(make_shared<lazy_table>()) {}
+
+    // One factor in Montgomery form and one not gives the plain product
+    [[nodiscard]] uint64_t mul(uint64_t a, uint64_t b) const { return mont.mul(mont.to(a), b); }
+    [[nodiscard]] uint64_t pow(uint64_t a, uint64_t e) const
+    {
+        PROFILE_SCOPE(probe::pow);
+        return mont.from(mont.pow(mont.to(a), e));
+    }
+
+    // out[i] = bases[i]^exps[i] for subgroup elements, so exponents are reduced mod q first
+    void pow_batch(span<const uint64_t> bases, span<const uint64_t> exps, span<uint64_t> out) const;
+
+    // g^e through the fixed-base table, built on first use and shared read-only by all copies of this group
+    [[nodiscard]] uint64_t pow_g(uint64_t e) const;
+
+    // Random subgroup elements, which double as nonces and, unchanged, as exponents
+    void random(span<uint64_t> out) const;
+    static constexpr size_t exponent_draws = 1;
+    [[nodiscard]] uint64_t to_exponent(span<const uint64_t> draws) const { return draws[0]; }
+    [[nodiscard]] static uint64_t fingerprint(uint64_t x) { return x; }
+
+    private:
+        struct lazy_table
+        {
+            once_flag built;
+            unique_ptr<fixed_base_table> table;
+        };
+        shared_ptr<lazy_table> g_table;
+};
+
+// The same subgroup with p < 2^32 in plain 64-bit products and remainders, the arithmetic the
+// simulator started out with; the baseline the other backends are measured against
+struct small_group
+{
+    using element = uint64_t;
+    using exponent = uint64_t;
+
+    uint64_t p{}, q{}, r{}, h{}, g{};
+
+    small_group() = default;
+    // Throws invalid_argument unless p < 2^32
+    explicit small_group(const group& G);
+
+    [[nodiscard]] uint64_t mul(uint64_t a, uint64_t b) const { return a * b % p; }
+    [[nodiscard]] uint64_t pow(uint64_t a, uint64_t e) const;
+    void pow_batch(span<const uint64_t> bases, span<const uint64_t> exps, span<uint64_t> out) const;
+    [[nodiscard]] uint64_t pow_g(uint64_t e) const { return pow(g, e % q); }
+
+    void random(span<uint64_t> out) const;
+    static constexpr size_t exponent_draws = 1;
+    [[nodiscard]] uint64_t to_exponent(span<const uint64_t> draws) const { return draws[0]; }
+    [[nodiscard]] static uint64_t fingerprint(uint64_t x) { return x; }
+};
+
+// Big-endian hex of the RFC 3526 MODP prime of the given size, 2048 or 3072 bits
+const char *modp_prime_hex(int bits);
+
+// The order-q subgroup of quadratic residues modulo a safe prime p = 2q + 1 of Bits bits, where DDH
+// is believed hard, with exponents of ExponentBits bits: short exponents, as RFC 3526 suggests, at
+// about twice the group's security level. Elements are fixed-width limb arrays, so messages and node
+// state stay trivially copyable and the arithmetic never allocates; only the generator's table of
+// powers, built once and shared by all copies, lives on the heap.
+template<int Bits, int ExponentBits>
+class mp_group
+{
+    static_assert(Bits % 64 == 0 && ExponentBits % 64 == 0 && ExponentBits < Bits);
+
+    public:
+        using element = wide_uint<Bits / 64>;
+        using exponent = wide_uint<ExponentBits / 64>;
+
+        element p, q, g;
+        wide_montgomery<Bits / 64> mont;
+
+        mp_group() = default;
+        mp_group(const element& p, const element& g) : p(p), q(p), g(g), mont(p), g_table(make_shared<lazy_table>())
+        {
+            q.shift_right();
+        }
+
+        // The RFC 3526 group of this size, with generator 2
+        static mp_group rfc3526() { return { element::from_hex(modp_prime_hex(Bits)), element(2) }; }
+
+        [[nodiscard]] element mul(const element& a, const element& b) const { return mont.mul(mont.to(a), b); }
+        [[nodiscard]] element pow(const element& a, const exponent& e) const
+        {
+            PROFILE_SCOPE(probe::pow);
+            return mont.from(mont.pow(mont.to(a), e));
+        }
+
+        void pow_batch(span<const element> bases, span<const exponent> exps, span<element> out) const
+        {
+            PROFILE_SCOPE(probe::pow_batch);
+            PROFILE_COUNT(tally::pow_lanes, out.size());
+            for (size_t i = 0; i < out.size(); ++i) out[i] = mont.from(mont.pow(mont.to(bases[i]), exps[i]));
+        }
+
+        // g^e from a table of g^(j * 2^(8i)), one multiplication per non-zero byte of e
+        [[nodiscard]] element pow_g(const exponent& e) const
+        {
+            PROFILE_SCOPE(probe::pow_g);
+            if (!g_table) return pow(g, e);
+            call_once(g_table->built, [this] {
+                element b = mont.to(g);
+                g_table->table.resize((size_t) rows << window);
+                for (int i = 0; i < rows; ++i)
+                {
+                    element *row = &g_table->table[(size_t) i << window];
+                    row[0] = mont.one();
+                    for (int j = 1; j < (1 << window); ++j) row[j] = mont.mul(row[j - 1], b);
+                    b = mont.mul(row[(1 << window) - 1], b);
+                }
+            });
+            element x = mont.one();
+            for (int i = 0; i < rows; ++i)
+                if (uint64_t const digit = e.bits(i * window, window)) x = mont.mul(x, g_table->table[((size_t) i << window) | digit]);
+            return mont.from(x);
+        }
+
+        // Raw 64-bit draws; the nonces need no group structure, and an exponent takes one per limb
+        static constexpr size_t exponent_draws = ExponentBits / 64;
+        void random(span<uint64_t> out) const
+        {
+            PROFILE_SCOPE(probe::random);
+            PROFILE_COUNT(tally::random_draws, out.size());
+            for (auto &v : out) v = getRandomBelow(UINT64_MAX);
+        }
+
+        // The ExponentBits-bit exponent of exponent_draws draws, each filling one limb
+        [[nodiscard]] exponent to_exponent(span<const uint64_t> draws) const
+        {
+            exponent e;
+            for (size_t i = 0; i < exponent_draws; ++i) e.limb[i] = draws[i];
+            return e;
+        }
+
+        // Elements are uniform in [1, p), so their low limb is as good a hash as any
+        [[nodiscard]] static uint64_t fingerprint(const element& x) { return x.limb[0]; }
+
+    private:
+        static constexpr int window = 8, rows = ExponentBits / window;
+
+        struct lazy_table
+        {
+            once_flag built;
+            vector<element> table;
+        };
+        shared_ptr<lazy_table> g_table;
+};
+
+using modp2048 = mp_group<2048, 256>;
+using modp3072 = mp_group<3072, 320>;
+
+// The backends a sweep can run on
+enum class group_kind { small, montgomery64, modp2048, modp3072 };
+
+// Names small, mont64, modp2048 and modp3072; throws invalid_argument on any other
+group_kind parse_group_kind(const string& name);
+const char *group_name(group_kind kind);
+
+#endif
@@ -0,0 +1,98 @@
+#include <cctype>
+#include <cmath>
+#include <numbers>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "latency.h"
+#include "random.h"
+
+using namespace std;
+
+namespace
+{
+    double unit(uint64_t bits)
+    {
+        return (double) (bits >> 11) * 0x1.0p-53;
+    }
+
+    uint64_t draw(uint64_t seed, uint64_t a, uint64_t b)
+    {
+        uint64_t state = seed ^ a;
+        state = splitmix64(state) ^ b;
+        return splitmix64(state);
+    }
+}
+
+delay_dist delay_dist::parse(const string& spec)
+{
+    vector<string> parts;
+    stringstream fields(spec);
+    for (string part; getline(fields, part, ':');) parts.push_back(part);
+
+    auto number = [&](size_t i) {
+        size_t used = 0;
+        double const v = i < parts.size() ? stod(parts[i], &used) : -1;
+        if (i >= parts.size() || used != parts[i].size() || !(v >= 0)) throw invalid_argument("bad delay " + spec);
+        return v;
+    };
+    delay_dist d;
+    if (parts.size() == 1 && !parts[0].empty() && (isdigit(parts[0][0]) || parts[0][0] == '.')) parts.insert(parts.begin(), "const");
+    if (parts.empty()) throw invalid_argument("bad delay " + spec);
+    string const &name = parts[0];
+    size_t arity = 1;
+    if (name == "const") d.kind = shape::constant;
+    else if (name == "uniform") { d.kind = shape::uniform; arity = 2; }
+    else if (name == "exp") d.kind = shape::exponential;
+    else if (name == "lognormal") { d.kind = shape::lognormal; arity = 2; }
+    else throw invalid_argument("delay must be const, uniform, exp or lognormal, not " + spec);
+    if (parts.size() != arity + 1) throw invalid_argument("bad delay " + spec);
+    d.a = number(1);
+    d.b = arity > 1 ? number(2) : 0;
+    if (d.kind == shape::uniform && d.b < d.a) throw invalid_argument("bad delay " + spec + ": upper bound below lower");
+    return d;
+}
+
+uint64_t delay_dist::sample_ns(uint64_t bits) const
+{
+    double us = a;
+    switch (kind)
+    {
+        case shape::uniform: us = a + (b - a) * unit(bits); break;
+        case shape::exponential: us = -a * log1p(-unit(bits)); break;
+        case shape::lognormal:
+        {
+            // Box-Muller on the two halves of the bits
+            double const u1 = ((double) (bits >> 32) + 0.5) * 0x1.0p-32, u2 = (double) (uint32_t) bits * 0x1.0p-32;
+            us = a * exp(b * sqrt(-2 * log(u1)) * cos(2 * numbers::pi * u2));
+            break;
+        }
+        default: break;
+    }
+    return (uint64_t) llround(max(us, 0.0) * 1000);
+}
+
+string delay_dist::describe() const
+{
+    ostringstream s;
+    switch (kind)
+    {
+        case shape::uniform: s << "uniform:" << a << ':' << b; break;
+        case shape::exponential: s << "exp:" << a; break;
+        case shape::lognormal: s << "lognormal:" << a << ':' << b; break;
+        default: s << "const:" << a; break;
+    }
+    return s.str();
+}
+
+uint64_t latency_model::link_ns(int source, int target) const
+{
+    return link.sample_ns(draw(seed, (uint32_t) source, (uint32_t) target));
+}
+
+uint64_t latency_model::delay_ns(int source, int target, uint64_t stream) const
+{
+    uint64_t const base = link_ns(source, target);
+    if (jitter.kind == delay_dist::shape::constant && jitter.a == 0) return base;
+    return base + jitter.sample_ns(draw(~seed, (uint64_t) (uint32_t) source << 32 | (uint32_t) target, stream));
+}
@@ -0,0 +1,46 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// A distribution of delays, written as one of
+//   const:x            always x
+//   uniform:a:b        uniform in [a, b)
+//   exp:mean           exponential
+//   lognormal:m:s      log-normal with median m and log-space standard deviation s
+// with times in microseconds; a bare number means const.
+struct delay_dist
+{
+    enum class shape : uint8_t { constant, uniform, exponential, lognormal };
+
+    shape kind = shape::constant;
+    double a = 0, b = 0;
+
+    // Throws invalid_argument on a malformed spec or a negative time
+    static delay_dist parse(const string& spec);
+
+    // The delay in nanoseconds at the given 64 random bits
+    [[nodiscard]] uint64_t sample_ns(uint64_t bits) const;
+
+    [[nodiscard]] string describe() const;
+};
+
+// Delays of a simulated network: every directed edge has a base latency drawn once from link, and
+// every message adds jitter drawn on its own. Both are pure functions of the seed and their
+// arguments, so a run is reproducible and independent of the order messages are handled in.
+struct latency_model
+{
+    delay_dist link{ delay_dist::shape::constant, 1000, 0 };
+    delay_dist jitter;
+    uint64_t seed = 0;
+
+    [[nodiscard]] uint64_t link_ns(int source, int target) const;
+
+    // Delay of one message over the edge; stream numbers the message within its instance
+    [[nodiscard]] uint64_t delay_ns(int source, int target, uint64_t stream) const;
+};
+
+#endif
@@ -1,155 +1,90 @@
 #include <iostream>
 #include <chrono>
-#include <deque>
 #include <filesystem>
-#include <vector>
-#include <fstream>
-#include <unordered_set>
-#include <iomanip>
+#include <memory>
 #include "util.h"
-#include "node.h"
-#include "message.h"
+#include "profile.h"
+#include "random.h"
+#include "sweep.h"
+#include "thread_pool.h"
 
 using namespace std;
 
 
-// Sends the appropriate message based on the message type
-vector<message> send(vector<node*> &nodes, const message& msg) {
-    switch (msg.t) {
-        case f: return nodes[msg.target]->forward(msg);
-        case b: return nodes[msg.target]->backward(msg);
-        case p: return nodes[msg.target]->publish(msg);
-        case broadcast:
-            for(auto v : nodes) v->broadcast(msg);
-            return {};
-        default: return {};
-    }
-}
-
-// Output writer
-void write_file(const string& s, long hash, group G)
+// Log files of one run are named after its start time and the group parameters; the writer adds the extension
+string log_path(long hash, const string& params)
 {
     filesystem::create_directory("out/");
     filesystem::create_directory("out/log/");
 
     string h_path = "out/log/" + to_string(hash) + " ";
-    string params = "[p=" + to_string(G.p) + ",q=" + to_string(G.q) + ",r=" + to_string(G.r) + ",h=" + to_string(G.h) + ",g=" + to_string(G.g) + "].log";
-    ofstream file(h_path + params, ofstream::app);
-    file << s;
-    file.close();
+    return h_path + params;
 }
 
-// Utility for generating a vector of node objects
-void generate_nodes(vector<vector<int>> &graph, vector<node*> &nodes, group G)
+string describe(const group& G)
 {
-    int idx = 0;
-    for (const vector<int> &neighbours : graph)
-    {
-        node *n = new node(idx, {}, neighbours, G);
-        nodes.push_back(n);
-        ++idx;
-    }
+    return "[p=" + to_string(G.p) + ",q=" + to_string(G.q) + ",r=" + to_string(G.r) + ",h=" + to_string(G.h) + ",g=" + to_string(G.g) + "]";
 }
 
+// The main function reads the sweep configuration and runs every combination of graph size, edge density, search depth and iteration
+int main(int argc, char *argv[]){
 
-// The main function that runs a single test case and returns (#cycles, #edges, #totalmsg, #forwardmsg, #backwardmsg, #publishmsg, #broadcastmsg, runtime)
-tuple<int, int, int, int, int, int, int, int> run(int n, vector<node*> &nodes, int l, int m, double d_avg)
-{
-    auto t1 = chrono::high_resolution_clock::now();
-    unordered_set<string> cycles;
-    unordered_set<string> global_cycles;
-    int global_msg_count = 0, old_msg_count = 0, cycle_edge_count = 0;
-    vector<int> msg_count = { 0, 0, 0, 0 };
-
-    for (int i = 0; i < n; ++i)
+    sweep_config config;
+    try
     {
-        auto msg_init = nodes[i]->initiate(l);
-        deque msg_queue(deque<message>(msg_init.begin(), msg_init.end()));
-        while (!msg_queue.empty())
-        {
-            message msg = msg_queue.front();
-            ++old_msg_count;
-            msg_count.at(msg.t)++;
-            if (msg.t == broadcast)
-            {
-                auto [_, res] = cycles.insert(msg.getpath());
-                if(res) cycle_edge_count += (int) msg.getpath().size() - 1;
-            }
-            auto mailbox = send(nodes, msg);
-            for (const auto &mm : mailbox) msg_queue.emplace_back(mm);
-            msg_queue.pop_front();
-        }
-        global_cycles.merge(cycles);
-        global_msg_count += old_msg_count;
-        old_msg_count = 0UL, cycles.clear();
+        config = sweep_config::parse(argc, argv);
     }
-    auto t2 = chrono::high_resolution_clock::now();
-    auto t_diff = chrono::duration_cast<chrono::milliseconds>(t2 - t1).count();
-
-    cout << fixed << setprecision(2)
-         << "n=" << n << ", "
-         << "m=" << m << ", "
-         << "d_avg="  << d_avg << ", "
-         << "l="      << l << ", "
-         << "n_cyc="  << global_cycles.size() << ", "
-         << "c_edge=" << cycle_edge_count << ", "
-         << "n_msg="  << global_msg_count << ", "
-         << "n_for="  << msg_count.at(f) << ", "
-         << "n_echo=" << msg_count.at(b) << ", "
-         << "n_pub="  << msg_count.at(p) << ", "
-         << "n_brd="  << msg_count.at(broadcast) << ", "
-         << "t="      << t_diff << "ms (" << t_diff / 1000 << "s)" << endl;
-    return {global_cycles.size(), cycle_edge_count, global_msg_count, msg_count.at(f), msg_count.at(b), msg_count.at(p), msg_count.at(broadcast), t_diff};
-}
-
-// The main function loops over the parameters graph size, edge density, search depth, and calls run for each combination of parameters
-int main(){
-
-    int l_lower    =   2;   // cycle length min 2
-    int l_upper    =   4;   // cycle length max 4
-    int n_lower    =   50;  // size min
-    int n_upper    =   50;  // size max
-    int d_lower    =   3;   // m min (lower m is lower average degree)
-    int d_upper    =   9;   // m max (higher m is higher average degree)
-    int iterations =   1;   // amount of times to repeat experiment
-
-    group G = getGroupParameters(20, 40);
+    catch (const exception& e)
+    {
+        cerr << e.what() << "\nusage: " << argv[0] << " [seed [threads [engine [graph]]]] [key=value ...] [config=<file>]" << endl;
+        return 1;
+    }
+    if (config.has_seed) setMasterSeed(config.seed);  // optional master seed for reproducible runs
+    config.seed = getMasterSeed();
+    // Opened before the workers start, so the counters follow them
+    unique_ptr<hw_counters> hardware = config.perf ? make_unique<hw_counters>() : nullptr;
+    auto pool = make_unique<thread_pool>(config.threads);
+
+    // The toy groups depend only on their sizes and come from the cache after the first run; the small
+    // one is narrow enough for plain 64-bit products
+    group G = config.backend == group_kind::small ? cachedGroupParameters(16, 15, config.group_cache) : cachedGroupParameters(20, 40, config.group_cache);
+    bool const wide = config.backend == group_kind::modp2048 || config.backend == group_kind::modp3072;
+    string const params = wide ? string("[") + group_name(config.backend) + "]" : describe(G);
     cout << "=============================================================PARAM=============================================================\n";
-    cout << "group [p=" << G.p << ", q=" << G.q << ", r=" << G.r << ", h=" << G.h << ", g=" << G.g << "]\ngraph size [" << n_lower;
-    cout << ',' << n_upper << "] with l [" << l_lower << ',' << l_upper << "] and degree [" << d_lower << ',' << d_upper << "]\n\n";
+    cout << "group " << group_name(config.backend) << " ";
+    if (wide) cout << "[RFC 3526 safe prime, g=2]";
+    else cout << "[p=" << G.p << ", q=" << G.q << ", r=" << G.r << ", h=" << G.h << ", g=" << G.g << "]";
+    if (config.backend == group_kind::montgomery64) cout << " pow_kernel=" << kernel_name(G.batch.kernel());
+    cout << " seed=" << config.seed << " threads=" << pool->size() << " engine=" << (config.rounds ? "rounds" : config.events ? "events" : "fifo") << " transport=" << transport_name(config.transport) << "\n";
+    if (config.events) cout << "latency " << config.latency.describe() << "us per edge, jitter " << config.jitter.describe() << "us per message\n";
+    if (config.graph_file.empty()) cout << "graph size [" << config.n_lower << ',' << config.n_upper << "] with";
+    else cout << "graph " << config.graph_file << " with";
+    cout << " l [" << config.l_lower << ',' << config.l_upper << "] and degree [" << config.d_lower << ',' << config.d_upper << "], " << config.iterations << " iteration(s)\n\n";
     cout << "=============================================================STATS=============================================================\n";
 
     auto clock = chrono::high_resolution_clock::now();
     auto hash = duration_cast<chrono::milliseconds>(clock.time_since_epoch()).count();
-    write_file("n,m,d_avg,l,n_cyc,c_edge,n_msg,n_for,n_echo,n_pub,n_brd,t\n", (long) hash, G);
-
-    // Determines the number of iterations for each set of parameters
-    for(int iteration = 0; iteration < iterations; ++iteration)
+    string const base = log_path((long) hash, params);
+    result_writer results(base, config.format);
+    // Graph and update files are only read once the sweep runs
+    try
     {
-        // Determines the size of the graph being generated
-        for(int i = n_lower; i <= n_upper; ++i)
+        switch (config.backend)
         {
-            // Determines the density of the graph
-            for(int j = d_lower; j <= d_upper; ++j)
-            {
-                // Generate a random graph with specified parameters (n=i, m=j, m0=j)
-                vector<node*> nodes;
-                nodes.reserve(i);
-                auto [m, d_avg, graph] = generate_scale_free_graph(j, j, i);
-                generate_nodes(graph, nodes, G);
-                string s = to_string(i) + ',' + to_string(m) + ',' + to_string(d_avg) + ',';
-
-                // Determines the upper cycle length (search depth)
-                for(int k = l_lower; k <= l_upper; ++k)
-                {
-                    auto [n_cyc, c_edge, n_msg, n_for, n_echo, n_pub, n_brd, t] = run(i, nodes, k, m, d_avg);
-                    string ss = s + to_string(k) + ',' + to_string(n_cyc) + ',' + to_string(c_edge) + ',' + to_string(n_msg) + ',' + to_string(n_for) + 
-                                ',' + to_string(n_echo)+ ',' + to_string(n_pub)+ ',' + to_string(n_brd)+ ',' + to_string(t) + '\n';
-                    write_file(ss, (long) hash, G);
-                }
-                for(auto node : nodes) delete node;
-            }
+            case group_kind::small: run_sweep(config, small_group(G), *pool, results); break;
+            case group_kind::modp2048: run_sweep(config, modp2048::rfc3526(), *pool, results); break;
+            case group_kind::modp3072: run_sweep(config, modp3072::rfc3526(), *pool, results); break;
+            default: run_sweep(config, G, *pool, results); break;
         }
     }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    // Workers add their hardware counts when they exit
+    pool.reset();
+    if (profile_enabled || hardware) write_profile(base, hardware ? hardware->read() : vector<pair<string, uint64_t>>{});
     return 0;
 }
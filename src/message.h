@@ -2,25 +2,37 @@
 #define MESSAGE_H
 
 #include <cstdint>
-#include <utility>
-#include <sstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include "group.h"
+#include "path.h"
 
 using namespace std;
 
-enum type { f, b, p, broadcast };
+enum type : uint8_t { f, b, p, broadcast };
 
-class message
+// Fixed-size, trivially copyable message header; publish and broadcast paths live in a path_store.
+// The group element it carries is as wide as the backend's, so messages of wide groups are large.
+template<group_backend G>
+class basic_message
 {
     public:
-        type t;             // message type
+        using element = typename G::element;
+
+        uint64_t r{};       // nonce
+        element gx{};       // ddh-safe x in g^x
         int source{};       // sender
         int target{};       // send to
-        int r{};            // nonce
-        int gx{};           // ddh-safe x in g^x
         int l{};            // time-to-live
-        vector<int> path{}; // source for publish
+        path_ref path{};    // source for publish
+        type t{};           // message type
+        uint16_t hop{};     // hops from the initiator to the forward this message descends from
+        uint16_t valid_to = UINT16_MAX;     // a search of length l sends it if hop <= l <= valid_to
+
+        basic_message() = default;
 
-        message(int source, int target, int r, int gx, int l)
+        basic_message(int source, int target, uint64_t r, const element& gx, int l)
         { // forward
             this->t       = f;
             this->source  = source;
@@ -30,7 +42,7 @@ class message
             this->l       = l;
         }
 
-        message(int source, int target, int r, int gx)
+        basic_message(int source, int target, uint64_t r, const element& gx)
         { // backward
             this->t       = b;
             this->source  = source;
@@ -39,37 +51,33 @@ class message
             this->gx      = gx;
         }
 
-        message(int source, int target, int r, int gx, vector<int> path)
+        basic_message(int source, int target, uint64_t r, const element& gx, path_ref path)
         { // publish
             this->t       = p;
             this->source  = source;
             this->target  = target;
             this->r       = r;
             this->gx      = gx;
-            this->path    = std::move(path);
+            this->path    = path;
         }
 
-        explicit message(vector<int> path)
+        explicit basic_message(path_ref path)
         { // broadcast
             this->t     = broadcast;
-            this->path  = std::move(path);
+            this->path  = path;
         }
 
-        [[nodiscard]] string getpath() const
+        [[nodiscard]] string getpath(const path_store& paths) const
         {
-            if (path.empty()) return "";
-            std::ostringstream oss;
-            oss << path[0];
-            for (size_t i = 1; i < path.size(); ++i) oss << ' ' << path[i];
-            return oss.str();
+            return paths.to_string(path);
         }
 
-        void print() const
+        void print(const path_store& paths) const
         {
             if(t == broadcast)
             {
                 cout << "[BRDC] (path={ ";
-                for(auto e : path) cout << e << " ";
+                for(auto e : paths.nodes(path)) cout << e << " ";
                 cout << "})" << endl;
                 return;
             }
@@ -88,7 +96,7 @@ class message
                     break;
                 case p:
                     cout << "t=p, r=" << r << ", path={ ";
-                    for(auto e : path) cout << e << " ";
+                    for(auto e : paths.nodes(path)) cout << e << " ";
                     cout << "})";
                     break;
                 default: break;
@@ -105,5 +113,9 @@ class message
         }
 };
 
+using message = basic_message<group>;
+
+static_assert(is_trivially_copyable_v<message>);
+
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <bit>
+#include "modarith.h"
+
+using namespace std;
+
+uint64_t mulMod(uint64_t a, uint64_t b, uint64_t m)
+{
+    return (uint64_t) ((unsigned __int128) a * b % m);
+}
+
+uint64_t powMod(uint64_t a, uint64_t b, uint64_t n)
+{
+    if (n & 1) {
+        montgomery const mont(n);
+        return mont.from(mont.pow(mont.to(a), b));
+    }
+    uint64_t x = 1 % n;
+    a %= n;
+    while (b > 0) {
+        if (b & 1) x = mulMod(x, a, n);
+        a = mulMod(a, a, n);
+        b >>= 1;
+    }
+    return x;
+}
+
+montgomery::montgomery(uint64_t n) : n(n)
+{
+    // Newton iteration doubles the number of correct low bits each step
+    uint64_t inv = n;
+    for (int i = 0; i < 5; ++i) inv *= 2 - n * inv;
+    n_inv = inv;
+    r1 = (uint64_t) (((unsigned __int128) 1 << 64) % n);
+    r2 = (uint64_t) ((unsigned __int128) r1 * r1 % n);
+}
+
+uint64_t montgomery::pow(uint64_t a, uint64_t e) const
+{
+    if (e == 0) return r1;
+    int const bits = 64 - countl_zero(e);
+    int const w = bits > 48 ? 5 : bits > 24 ? 4 : bits > 8 ? 3 : 1;
+
+    // Odd powers a^1, a^3, ..., a^(2^w - 1)
+    uint64_t odd[16];
+    odd[0] = a;
+    uint64_t const a2 = mul(a, a);
+    for (int i = 1; i < (1 << (w - 1)); ++i) odd[i] = mul(odd[i - 1], a2);
+
+    uint64_t x = r1;
+    int i = bits - 1;
+    while (i >= 0)
+    {
+        if (!((e >> i) & 1))
+        {
+            x = mul(x, x);
+            --i;
+            continue;
+        }
+        // Longest window e[i..j] of at most w bits that ends in a one
+        int j = max(i - w + 1, 0);
+        while (!((e >> j) & 1)) ++j;
+        uint64_t const window = (e >> j) & ((1ULL << (i - j + 1)) - 1);
+        for (int k = 0; k <= i - j; ++k) x = mul(x, x);
+        x = mul(x, odd[window >> 1]);
+        i = j - 1;
+    }
+    return x;
+}
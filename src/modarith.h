@@ -0,0 +1,48 @@
+#ifndef MODARITH_H
+#define MODARITH_H
+
+#include <cstdint>
+
+using namespace std;
+
+uint64_t mulMod(uint64_t, uint64_t, uint64_t);
+uint64_t powMod(uint64_t, uint64_t, uint64_t);
+
+// Montgomery arithmetic modulo an odd n with R = 2^64; values in Montgomery form are a*R mod n
+class montgomery
+{
+    public:
+        montgomery() = default;
+        explicit montgomery(uint64_t n);
+
+        [[nodiscard]] uint64_t modulus() const { return n; }
+        [[nodiscard]] uint64_t one() const { return r1; }
+
+        [[nodiscard]] uint64_t to(uint64_t a) const { return mul(a % n, r2); }
+        [[nodiscard]] uint64_t from(uint64_t a) const { return reduce(0, a); }
+
+        [[nodiscard]] uint64_t mul(uint64_t a, uint64_t b) const
+        {
+            auto t = (unsigned __int128) a * b;
+            return reduce((uint64_t) (t >> 64), (uint64_t) t);
+        }
+
+        // a^e for a in Montgomery form, using sliding windows
+        [[nodiscard]] uint64_t pow(uint64_t a, uint64_t e) const;
+
+        // REDC of hi*2^64 + lo, requires hi < n
+        [[nodiscard]] uint64_t reduce(uint64_t hi, uint64_t lo) const
+        {
+            uint64_t const m = lo * n_inv;
+            auto const mn = (uint64_t) (((unsigned __int128) m * n) >> 64);
+            return hi >= mn ? hi - mn : hi - mn + n;
+        }
+
+    private:
+        uint64_t n  = 1;    // odd modulus
+        uint64_t n_inv = 1; // n^-1 mod 2^64
+        uint64_t r1 = 0;    // R mod n
+        uint64_t r2 = 0;    // R^2 mod n
+};
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef MULTIPRECISION_H
+#define MULTIPRECISION_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+using namespace std;
+
+// Unsigned integer of N 64-bit limbs, least significant first; a plain array, so values live wherever
+// their owner does and never touch the heap
+template<size_t N>
+struct wide_uint
+{
+    uint64_t limb[N]{};
+
+    wide_uint() = default;
+    explicit wide_uint(uint64_t low) { limb[0] = low; }
+
+    // Big-endian hexadecimal, spaces allowed; throws invalid_argument on other characters or overflow
+    static wide_uint from_hex(string_view hex)
+    {
+        wide_uint x;
+        for (char c : hex)
+        {
+            if (c == ' ' || c == '\n') continue;
+            int const digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (digit < 0 || x.limb[N - 1] >> 60) throw invalid_argument("bad hexadecimal number");
+            for (size_t i = N - 1; i > 0; --i) x.limb[i] = x.limb[i] << 4 | x.limb[i - 1] >> 60;
+            x.limb[0] = x.limb[0] << 4 | (uint64_t) digit;
+        }
+        return x;
+    }
+
+    [[nodiscard]] int bit_width() const
+    {
+        for (size_t i = N; i-- > 0;)
+            if (limb[i]) return (int) (64 * i) + std::bit_width(limb[i]);
+        return 0;
+    }
+
+    [[nodiscard]] bool bit(int i) const { return (limb[i / 64] >> (i % 64)) & 1; }
+
+    // The w bits from bit i up, for w < 64
+    [[nodiscard]] uint64_t bits(int i, int w) const
+    {
+        uint64_t x = limb[i / 64] >> (i % 64);
+        if (i % 64 + w > 64 && (size_t) i / 64 + 1 < N) x |= limb[i / 64 + 1] << (64 - i % 64);
+        return x & ((1ULL << w) - 1);
+    }
+
+    bool operator==(const wide_uint&) const = default;
+
+    friend bool operator<(const wide_uint& a, const wide_uint& b)
+    {
+        for (size_t i = N; i-- > 0;)
+            if (a.limb[i] != b.limb[i]) return a.limb[i] < b.limb[i];
+        return false;
+    }
+
+    // Subtracts b in place and returns the borrow out of the top limb
+    uint64_t subtract(const wide_uint& b)
+    {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            auto const d = (unsigned __int128) limb[i] - b.limb[i] - borrow;
+            limb[i] = (uint64_t) d;
+            borrow = (uint64_t) (d >> 64) & 1;
+        }
+        return borrow;
+    }
+
+    // Shifts left by one bit in place and returns the bit shifted out
+    uint64_t shift_left()
+    {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            uint64_t const out = limb[i] >> 63;
+            limb[i] = limb[i] << 1 | carry;
+            carry = out;
+        }
+        return carry;
+    }
+
+    void shift_right()
+    {
+        for (size_t i = 0; i + 1 < N; ++i) limb[i] = limb[i] >> 1 | limb[i + 1] << 63;
+        limb[N - 1] >>= 1;
+    }
+
+    friend ostream& operator<<(ostream& out, const wide_uint& x)
+    {
+        auto const flags = out.flags();
+        auto const fill = out.fill('0');
+        out << "0x" << hex;
+        for (size_t i = N; i-- > 0;) out << setw(16) << x.limb[i];
+        out.fill(fill);
+        out.flags(flags);
+        return out;
+    }
+};
+
+// Montgomery arithmetic modulo an odd N-limb n with R = 2^(64N), by coarsely integrated operand
+// scanning: each limb of b is multiplied in and then reduced away, so a product takes 2N^2 + N
+// word multiplications and N + 2 words of scratch on the stack
+template<size_t N>
+class wide_montgomery
+{
+    public:
+        using value = wide_uint<N>;
+
+        wide_montgomery() = default;
+        explicit wide_montgomery(const value& n) : n(n)
+        {
+            // Newton iteration for n^-1 mod 2^64, then R mod n and R^2 mod n by doubling 1
+            uint64_t inv = n.limb[0];
+            for (int i = 0; i < 5; ++i) inv *= 2 - n.limb[0] * inv;
+            n_neg_inv = 0 - inv;
+            value x(1);
+            for (size_t i = 0; i < 128 * N; ++i)
+            {
+                uint64_t const carry = x.shift_left();
+                if (carry || !(x < n)) x.subtract(n);
+                if (i + 1 == 64 * N) r1 = x;
+            }
+            r2 = x;
+        }
+
+        [[nodiscard]] const value& modulus() const { return n; }
+        [[nodiscard]] const value& one() const { return r1; }
+
+        // a must be below n
+        [[nodiscard]] value to(const value& a) const { return mul(a, r2); }
+        [[nodiscard]] value from(const value& a) const { return mul(a, value(1)); }
+
+        [[nodiscard]] value mul(const value& a, const value& b) const
+        {
+            uint64_t t[N + 2] = {};
+            for (size_t i = 0; i < N; ++i)
+            {
+                uint64_t carry = 0;
+                for (size_t j = 0; j < N; ++j)
+                {
+                    auto const s = (unsigned __int128) a.limb[j] * b.limb[i] + t[j] + carry;
+                    t[j] = (uint64_t) s;
+                    carry = (uint64_t) (s >> 64);
+                }
+                auto s = (unsigned __int128) t[N] + carry;
+                t[N] = (uint64_t) s;
+                t[N + 1] = (uint64_t) (s >> 64);
+
+                // Adding m*n clears the low limb, which the shift by one limb then drops
+                uint64_t const m = t[0] * n_neg_inv;
+                s = (unsigned __int128) m * n.limb[0] + t[0];
+                carry = (uint64_t) (s >> 64);
+                for (size_t j = 1; j < N; ++j)
+                {
+                    s = (unsigned __int128) m * n.limb[j] + t[j] + carry;
+                    t[j - 1] = (uint64_t) s;
+                    carry = (uint64_t) (s >> 64);
+                }
+                s = (unsigned __int128) t[N] + carry;
+                t[N - 1] = (uint64_t) s;
+                t[N] = t[N + 1] + (uint64_t) (s >> 64);
+            }
+            value x;
+            for (size_t i = 0; i < N; ++i) x.limb[i] = t[i];
+            if (t[N] || !(x < n)) x.subtract(n);
+            return x;
+        }
+
+        // a^e for a in Montgomery form, using sliding windows
+        template<size_t E>
+        [[nodiscard]] value pow(const value& a, const wide_uint<E>& e) const
+        {
+            int const bits = e.bit_width();
+            if (bits == 0) return r1;
+            int const w = bits > 160 ? 5 : bits > 48 ? 4 : bits > 8 ? 3 : 1;
+
+            // Odd powers a^1, a^3, ..., a^(2^w - 1)
+            value odd[16];
+            odd[0] = a;
+            value const a2 = mul(a, a);
+            for (int i = 1; i < (1 << (w - 1)); ++i) odd[i] = mul(odd[i - 1], a2);
+
+            value x = r1;
+            int i = bits - 1;
+            while (i >= 0)
+            {
+                if (!e.bit(i))
+                {
+                    x = mul(x, x);
+                    --i;
+                    continue;
+                }
+                // Longest window e[i..j] of at most w bits that ends in a one
+                int j = max(i - w + 1, 0);
+                while (!e.bit(j)) ++j;
+                uint64_t const window = e.bits(j, i - j + 1);
+                for (int k = 0; k <= i - j; ++k) x = mul(x, x);
+                x = mul(x, odd[window >> 1]);
+                i = j - 1;
+            }
+            return x;
+        }
+
+    private:
+        value n;
+        uint64_t n_neg_inv = 0;     // -n^-1 mod 2^64
+        value r1;                   // R mod n
+        value r2;                   // R^2 mod n
+};
+
+#endif
@@ -1,94 +1,201 @@
 #include "node.h"
+#include "profile.h"
 
-vector<message> node::initiate(int l)
+template<group_backend G>
+uint32_t basic_node_states<G>::add(int id)
 {
-    vector<message> messages;
-	for (int target : n_out)
+    ids.push_back(id);
+    keys.emplace_back(mem);
+    init.emplace_back(mem);
+    routes.emplace_back(mem);
+    route_index.emplace_back(mem);
+    publish_index.emplace_back(mem);
+    publish_links.emplace_back(mem);
+    return (uint32_t) ids.size() - 1;
+}
+
+template<group_backend G>
+void basic_node_states<G>::clear()
+{
+    ids.clear();
+    keys.clear();
+    init.clear();
+    routes.clear();
+    route_index.clear();
+    publish_index.clear();
+    publish_links.clear();
+}
+
+template<group_backend G>
+size_t basic_node_states<G>::bytes() const
+{
+    return ids.capacity() * sizeof(int)
+         + keys.capacity() * sizeof(keys[0])
+         + init.capacity() * sizeof(init[0])
+         + routes.capacity() * sizeof(routes[0])
+         + route_index.capacity() * sizeof(route_index[0])
+         + publish_index.capacity() * sizeof(publish_index[0])
+         + publish_links.capacity() * sizeof(publish_links[0]);
+}
+
+template<group_backend G>
+void basic_node<G>::initiate(int l, vector<message>& messages)
+{
+    // An exponent's draws, then a nonce, per neighbour
+    constexpr size_t k = G::exponent_draws;
+    vector<uint64_t> draws((k + 1) * n_out.size());
+    grp.random(draws);
+    for (size_t i = 0; i < n_out.size(); ++i)
  	{
-		auto x = getRandomInGroup(G);
-		auto r = getRandomInGroup(G);
-		init.emplace_back(x, r);
+        int target = n_out[i];
+		exponent const x = grp.to_exponent(span(draws).subspan((k + 1) * i, k));
+		auto r = draws[(k + 1) * i + k];
+		states.init[slot].insert(r, x);
 
-        message msg_f = { id, target, r, powMod(G.g, x, G.p), l - 1 };
+        message msg_f = { id, target, r, grp.pow_g(x), l - 1 };
+        msg_f.hop = 1;
         messages.emplace_back(msg_f);
 	}
-    return messages;
 }
 
-vector<message> node::forward(const message& msg)
+template<group_backend G>
+void basic_node<G>::forward(const message& msg, vector<message>& messages)
 {
-    auto y = getRandomInGroup(G);
-    keys.push_back(powMod(msg.gx, y, G.p));
+    size_t const fan_out = msg.l == 0UL ? 0 : n_out.size();
+    constexpr size_t k = G::exponent_draws;
+    vector<uint64_t> draws((k + 1) * fan_out + k);
+    grp.random(draws);     // y, then a nonce and a key per neighbour
+    exponent const y = grp.to_exponent(span(draws).first(k));
 
-    message msg_b = { id, msg.source, msg.r, powMod(G.g, y, G.p) };
-    vector<message> messages;
-    messages.reserve(n_out.size() + 1);
+    // All powers share the base msg.gx: lane 0 is this node's key, the rest blind it per neighbour
+    vector<element> bases(fan_out + 1, msg.gx), powers(fan_out + 1);
+    vector<exponent> exps(fan_out + 1);
+    exps[0] = y;
+    for (size_t i = 0; i < fan_out; ++i) exps[i + 1] = grp.to_exponent(span(draws).subspan(k + (k + 1) * i + 1, k));
+    grp.pow_batch(bases, exps, powers);
+    add_key(powers[0], msg.hop);
+
+    message msg_b = { id, msg.source, msg.r, grp.pow_g(y) };
+    msg_b.hop = msg.hop;
     messages.emplace_back(msg_b);
-    if(msg.l == 0UL) return messages;
 
-    for (int target : n_out)
+    auto &routes = states.routes[slot];
+    for (size_t i = 0; i < fan_out; ++i)
     {
-        route route = {
+        route<G> route = {
                 .s_id       = msg.source,
                 .s_nonce    = msg.r,
-                .t_id       = target,
-                .t_nonce    = getRandomInGroup(G),
+                .t_id       = n_out[i],
+                .t_nonce    = draws[k + (k + 1) * i],
                 .f_gx       = msg.gx,
-                .b_gx       = 0,
-                .key        = getRandomInGroup(G),
+                .b_gx       = {},
+                .key        = exps[i + 1],
         };
+        states.route_index[slot].insert(route.t_nonce, (uint32_t) routes.size());   // the first route with a nonce wins, as a scan would
         routes.emplace_back(route);
-        message msg_f = { id,route.t_id,route.t_nonce,powMod(msg.gx, route.key, G.p), msg.l - 1 };
+        message msg_f = { id, route.t_id, route.t_nonce, powers[i + 1], msg.l - 1 };
+        msg_f.hop = (uint16_t) (msg.hop + 1);
         messages.push_back(msg_f);
     }
-    return messages;
 }
 
-vector<message> node::backward(const message& msg)
+template<group_backend G>
+void basic_node<G>::backward(const message& msg, vector<message>& messages)
 {
-    vector<message> messages;
-    messages.reserve(1);
-    auto xr = std::ranges::find(init, msg.r, &pair<int, int>::second);
-    if (xr != init.end())
+    auto &keys = states.keys[slot];
+    const exponent *x = nullptr;
+    const uint32_t *idx = nullptr;
     {
-        int key = powMod(msg.gx, xr->first, G.p);
-        if (std::find(keys.begin(), keys.end(), key) != keys.end()) {
-            messages.emplace_back(id, msg.source, msg.r, msg.gx, vector<int>{id});
+        PROFILE_SCOPE(probe::route_lookup);
+        x = states.init[slot].find(msg.r);
+        if (x == nullptr) idx = states.route_index[slot].find(msg.r);
+    }
+    if (x != nullptr)
+    {
+        element const key = grp.pow(msg.gx, *x);
+        if (const uint16_t *hop = keys.find(G::fingerprint(key))) {
+            // Only searches long enough to have made both keys see the match
+            message &msg_p = messages.emplace_back(id, msg.source, msg.r, msg.gx, paths->extend({}, id));
+            msg_p.hop = max(msg.hop, *hop);
+            msg_p.valid_to = msg.valid_to;
         }
-        keys.push_back(key);
-        return messages;
+        add_key(key, msg.hop);
+        return;
+    }
+    if (idx == nullptr)
+    {
+        PROFILE_COUNT(tally::route_misses, 1);
+        return;
     }
-    auto route = std::ranges::find(routes, msg.r, &route::t_nonce);
-    if (route == routes.end()) return messages;
-    route->b_gx = msg.gx;
-    messages.emplace_back(id, (*route).s_id, (*route).s_nonce, powMod(msg.gx, (*route).key, G.p));
-    return messages;
+    route<G> &route = states.routes[slot][*idx];
+    element const b_key = grp.pow(msg.gx, route.key);
+    messages.emplace_back(id, route.s_id, route.s_nonce, b_key).hop = msg.hop;
+
+    // b_gx^key is now known, so index the route for the publish phase
+    if (route.b_gx == msg.gx) return;
+    route.b_gx = msg.gx;
+    auto &links = states.publish_links[slot];
+    // Searches at least msg.hop long see this message replace b_gx; older links already cut shorter stop the walk
+    auto const cut = (uint16_t) (msg.hop - 1);
+    for (uint32_t i = route.last_link; i != publish_link<G>::none && links[i].valid_to > cut; i = links[i].older) links[i].valid_to = cut;
+    auto [head, inserted] = states.publish_index[slot].insert({ route.s_nonce, G::fingerprint(b_key) }, (uint32_t) links.size());
+    links.push_back({ *idx, inserted ? publish_link<G>::none : *head, msg.gx, route.last_link, msg.hop, UINT16_MAX });
+    *head = route.last_link = (uint32_t) links.size() - 1;
 }
 
-vector<message> node::publish(const message& msg)
+template<group_backend G>
+void basic_node<G>::publish(const message& msg, vector<message>& messages)
 {
-    vector<message> messages;
-    messages.reserve(routes.size());
-    vector<int> ext_path = msg.path;
-    ext_path.push_back(id);
+    path_ref ext_path = paths->extend(msg.path, id);
 
-    if (id == msg.path.front())
+    if (id == paths->front(msg.path))
     {
-        messages.emplace_back(ext_path);
-        return messages;
+        message &msg_brd = messages.emplace_back(ext_path);
+        msg_brd.hop = msg.hop;
+        msg_brd.valid_to = msg.valid_to;
+        return;
     }
 
-    for (auto& route : routes)
+    PROFILE_SCOPE(probe::publish_scan);
+    const auto &links = states.publish_links[slot];
+    const uint32_t *head = states.publish_index[slot].find({ msg.r, G::fingerprint(msg.gx) });
+    for (uint32_t i = head ? *head : publish_link<G>::none; i != publish_link<G>::none; i = links[i].next)
     {
-        if (powMod(route.b_gx, route.key, G.p) == msg.gx && route.s_nonce == msg.r)
-            messages.emplace_back(id, route.t_id, route.t_nonce, route.b_gx, ext_path);
+        PROFILE_COUNT(tally::publish_links, 1);
+        // Skip links that exist for none of the lengths still sent: made by a deeper search only, or
+        // left behind by a later backward message
+        uint16_t const hop = max(msg.hop, links[i].hop), valid_to = min(msg.valid_to, links[i].valid_to);
+        if (valid_to < max<int>(hop, shortest))
+        {
+            PROFILE_COUNT(tally::stale_links, 1);
+            continue;
+        }
+        const route<G> &route = states.routes[slot][links[i].route];
+        message &msg_p = messages.emplace_back(id, route.t_id, route.t_nonce, links[i].b_gx, ext_path);
+        msg_p.hop = hop;
+        msg_p.valid_to = valid_to;
     }
-    return messages;
 }
 
-void node::broadcast(const message& msg) {
-    return;
-    // auto path = msg.path;
-    // for(size_t i = 0; i < path.size() - 1; ++i)
-        // topology.emplace_back(path[i], path[(i + 1) % path.size()]);
+template<group_backend G>
+void basic_node<G>::add_key(const element& key, uint16_t hop)
+{
+    auto [seen, inserted] = states.keys[slot].insert(G::fingerprint(key), hop);
+    if (!inserted) *seen = min(*seen, hop);
 }
+
+void known_topology::learn(const path_store& paths, path_ref path)
+{
+    thread_local vector<int> nodes;
+    paths.nodes(path, nodes);
+    for (size_t i = 0; i + 1 < nodes.size(); ++i) edges.insert(key(nodes[i], nodes[i + 1]));
+}
+
+template struct basic_node_states<small_group>;
+template struct basic_node_states<group>;
+template struct basic_node_states<modp2048>;
+template struct basic_node_states<modp3072>;
+template class basic_node<small_group>;
+template class basic_node<group>;
+template class basic_node<modp2048>;
+template class basic_node<modp3072>;
@@ -5,63 +5,137 @@
 #include <utility>
 #include <vector>
 #include <cstdint>
+#include <memory_resource>
+#include <span>
 #include "util.h"
 #include "message.h"
+#include "path.h"
+#include "flat_hash.h"
+#include "graph.h"
 
 using namespace std;
 
+template<group_backend G>
 struct route
 {
-    int s_id, s_nonce;       // source id, nonce and key
-    int t_id, t_nonce;	     // same but gx can be found from key
-    int f_gx, b_gx;          // back and forward keys
-    int key; 	             // instance-specific
+    int s_id; uint64_t s_nonce;         // source id, nonce and key
+    int t_id; uint64_t t_nonce;         // same but gx can be found from key
+    typename G::element f_gx, b_gx;     // back and forward keys
+    typename G::exponent key;           // instance-specific
+    uint32_t last_link = UINT32_MAX;    // newest publish link of the route
 };
 
-struct edge
+// One entry of a publish chain: a route whose b_gx^key matched the indexed value when b_gx was b_gx.
+// The link exists only in searches long enough to have sent that backward message, of length at least
+// hop, and a later backward message replaces the route's b_gx, so it only holds up to valid_to.
+template<group_backend G>
+struct publish_link
 {
-    int source;
-    int target;
+    uint32_t route;
+    uint32_t next;          // next link with the same (s_nonce, b_gx^key), or none
+    typename G::element b_gx;
+    uint32_t older;         // previous link of the same route, or none
+    uint16_t hop, valid_to;
+    static constexpr uint32_t none = UINT32_MAX;
 };
 
-class node
+// Protocol state of the nodes one shard has touched in the current instance, one array per field.
+// Slot i holds the state of node ids[i]; its containers allocate from the shard's arena. Elements
+// are hashed and indexed by their fingerprints.
+template<group_backend G>
+struct basic_node_states
 {
+    pmr::memory_resource *mem;
+    vector<int> ids;
+    vector<flat_map<uint64_t, uint16_t>> keys;                      // all keys -> fewest hops of a search that made it
+    vector<flat_map<uint64_t, typename G::exponent>> init;          // nonce -> x of every instance the node initiated
+    vector<pmr::vector<route<G>>> routes;                           // for all instances
+    vector<flat_map<uint64_t, uint32_t>> route_index;               // t_nonce -> route
+    vector<flat_map<pair<uint64_t, uint64_t>, uint32_t>> publish_index;   // (s_nonce, b_gx^key) -> publish chain
+    vector<pmr::vector<publish_link<G>>> publish_links;
+
+    static constexpr uint32_t none = UINT32_MAX;
+
+    explicit basic_node_states(pmr::memory_resource *mem = pmr::get_default_resource()) : mem(mem) {}
+
+    // Gives node id a fresh slot and returns it
+    uint32_t add(int id);
+
+    [[nodiscard]] size_t size() const { return ids.size(); }
+
+    // Drops every slot; must run before the arena holding them is rewound. The arrays keep
+    // their capacity, so the next instance touches its nodes without allocating.
+    void clear();
+
+    // Bytes held by the arrays themselves, not counting what the containers put in the arena
+    [[nodiscard]] size_t bytes() const;
+};
+
+using node_states = basic_node_states<group>;
+
+// Edges the nodes learned from broadcast cycles, each directed edge packed into one 64-bit key.
+// Every node receives every broadcast and so learns the same edges; one shared, deduplicated set
+// stands in for each node's copy, making the cost per node its size divided by the node count.
+class known_topology
+{
+    public:
+        // Learns the edges of a broadcast path [s, ..., s]
+        void learn(const path_store& paths, path_ref path);
+        void merge(const known_topology& other) { other.edges.for_each([&](uint64_t e) { edges.insert(e); }); }
+
+        [[nodiscard]] bool contains(int source, int target) const { return edges.contains(key(source, target)); }
+
+        // Calls f with the packed key of every learned edge
+        template<typename F>
+        void for_each(F f) const { edges.for_each(f); }
+
+        [[nodiscard]] size_t size() const { return edges.size(); }
+        [[nodiscard]] size_t bytes() const { return edges.bytes(); }
+        // bytes() once the given number of distinct edges has been learned
+        [[nodiscard]] static size_t bytes_for(size_t edges) { return flat_set<uint64_t>::bytes_for(edges); }
+        void clear() { edges.clear(); }
+
     private:
+        flat_set<uint64_t> edges;
+
+        static uint64_t key(int source, int target) { return (uint64_t) (uint32_t) source << 32 | (uint32_t) target; }
+};
+
+// A node as its protocol handlers see it: the id, out-neighbours and state slot of one node.
+// Nodes are not stored; the simulation builds one per delivered message.
+template<group_backend G>
+class basic_node
+{
+    private:
+        using message = basic_message<G>;
+        using element = typename G::element;
+        using exponent = typename G::exponent;
+
 		int id;					        // unique node id
-		vector<int> n_in; 		        // incoming neighbours
-		vector<int> n_out; 		        // outgoing neighbours
-		vector<int> keys;               // all keys
-        vector<pair<int, int>> init;    // all nonces
-		vector<route> routes;           // for all instances
-        vector<edge> topology;          // known non-neighbouring edges
-        group G;				        // ddh-safe subgroup
+		span<const int> n_out; 		    // outgoing neighbours, a row of the graph
+        basic_node_states<G> &states;   // state arrays of the node's shard
+        uint32_t slot;                  // the node's index in states
+        path_store *paths;              // where publish paths are extended
+        const G &grp;				    // ddh-safe subgroup
+        int shortest;                   // shortest search length whose messages are sent
+
+        // Records a key made by a search of hop hops, keeping the fewest
+        void add_key(const element& key, uint16_t hop);
 
     public:
-		node(int id, vector<int> n_in, vector<int> n_out, group G)
-		{
-			this->id 	= id;
-			this->n_in 	= std::move(n_in);
-			this->n_out = std::move(n_out);
-            this->G     = G;
-		}
-
-        vector<message> initiate(int);
-        vector<message> forward(const message& msg);
-        vector<message> backward(const message& msg);
-        vector<message> publish(const message& msg);
-        void broadcast(const message& msg);
-
-        void topology_print()
-        {
-            cout << "[TOP~" << id << "] | ";
-            for(edge e : topology) cout << e.source << "->" << e.target << " | ";
-            cout << endl;
-        }
+		basic_node(int id, span<const int> n_out, basic_node_states<G>& states, uint32_t slot, const G& grp, path_store *paths, int shortest)
+            : id(id), n_out(n_out), states(states), slot(slot), paths(paths), grp(grp), shortest(shortest) {}
+
+        // Protocol handlers append the messages they send to out
+        void initiate(int, vector<message>& out);
+        void forward(const message& msg, vector<message>& out);
+        void backward(const message& msg, vector<message>& out);
+        void publish(const message& msg, vector<message>& out);
 
         void keys_print()
         {
             string s = "[KEY~" + to_string(id) + "] (";
-            for (int e: keys) s += to_string(e) + ", ";
+            states.keys[slot].for_each([&](uint64_t e, uint16_t) { s += to_string(e) + ", "; });
             s.erase(s.end() - 1, s.end());
             cout << s << endl;
         }
@@ -70,8 +144,8 @@ class node
         {
             return n_out.size();
         }
-
-		// virtual ~node();
 };
 
-#endif
\ No newline at end of file
+using node = basic_node<group>;
+
+#endif
@@ -0,0 +1,68 @@
+#include <sstream>
+#include "path.h"
+
+using namespace std;
+
+path_store::~path_store()
+{
+    for (auto &segment : segments) delete[] segment.load();
+}
+
+path_store::entry& path_store::slot(uint32_t id)
+{
+    int const k = segment_of(id);
+    entry *segment = segments[k].load(memory_order_acquire);
+    if (segment == nullptr)
+    {
+        // Several threads may race to allocate the same segment; one wins, the rest free theirs
+        auto *fresh = new entry[(size_t) 1 << (base_bits + k)];
+        if (segments[k].compare_exchange_strong(segment, fresh, memory_order_acq_rel)) segment = fresh;
+        else delete[] fresh;
+    }
+    return segment[id - segment_start(k)];
+}
+
+path_ref path_store::extend(path_ref path, int node)
+{
+    entry e{ node, path.id, node, 1 };
+    if (!path.empty())
+    {
+        const entry &parent = at(path.id);
+        e.first  = parent.first;
+        e.length = parent.length + 1;
+    }
+    uint32_t const id = count.fetch_add(1, memory_order_relaxed);
+    slot(id) = e;
+    return { id };
+}
+
+vector<int> path_store::nodes(path_ref path) const
+{
+    vector<int> result;
+    nodes(path, result);
+    return result;
+}
+
+void path_store::nodes(path_ref path, vector<int>& out) const
+{
+    out.resize(length(path));
+    for (auto i = out.size(); i-- > 0; path.id = at(path.id).parent) out[i] = at(path.id).node;
+}
+
+string path_store::to_string(path_ref path) const
+{
+    auto const path_nodes = nodes(path);
+    if (path_nodes.empty()) return "";
+    std::ostringstream oss;
+    oss << path_nodes[0];
+    for (size_t i = 1; i < path_nodes.size(); ++i) oss << ' ' << path_nodes[i];
+    return oss.str();
+}
+
+size_t path_store::bytes() const
+{
+    size_t total = 0;
+    for (size_t k = 0; k < segments.size(); ++k)
+        if (segments[k].load(memory_order_relaxed)) total += sizeof(entry) << (base_bits + k);
+    return total;
+}
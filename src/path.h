@@ -0,0 +1,77 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Handle to a path in a path_store; the default handle is the empty path
+struct path_ref
+{
+    uint32_t id = UINT32_MAX;
+
+    [[nodiscard]] bool empty() const { return id == UINT32_MAX; }
+};
+
+// Publish paths as persistent parent-pointer lists: extending a path shares its prefix with every
+// other extension of it, so it takes O(1) time and no allocation once the store has warmed up.
+// Entries live in segments of doubling size that never move, so threads may extend concurrently;
+// a path is safe to read once the thread that created it has synchronised with the reader.
+class path_store
+{
+    public:
+        path_store() = default;
+        path_store(const path_store&) = delete;
+        path_store& operator=(const path_store&) = delete;
+        ~path_store();
+
+        path_ref extend(path_ref path, int node);
+
+        [[nodiscard]] int front(path_ref path) const { return at(path.id).first; }
+        [[nodiscard]] int back(path_ref path) const { return at(path.id).node; }
+        [[nodiscard]] size_t length(path_ref path) const { return path.empty() ? 0 : at(path.id).length; }
+
+        // Nodes of the path from front to back
+        [[nodiscard]] vector<int> nodes(path_ref path) const;
+        void nodes(path_ref path, vector<int>& out) const;
+        [[nodiscard]] string to_string(path_ref path) const;
+
+        [[nodiscard]] size_t size() const { return count.load(memory_order_relaxed); }
+        [[nodiscard]] size_t bytes() const;
+
+        // Invalidates every handle, keeping the storage; not safe against concurrent extend()
+        void clear() { count.store(0, memory_order_relaxed); }
+
+    private:
+        struct entry
+        {
+            int node;
+            uint32_t parent;
+            int first;
+            uint32_t length;
+        };
+
+        static constexpr int base_bits = 10;    // segment k holds 2^(base_bits + k) entries
+
+        array<atomic<entry*>, 32 - base_bits + 1> segments{};
+        atomic<uint32_t> count{0};
+
+        static int segment_of(uint32_t id) { return bit_width((id >> base_bits) + 1) - 1; }
+        static uint32_t segment_start(int k) { return ((1U << k) - 1) << base_bits; }
+
+        [[nodiscard]] const entry& at(uint32_t id) const
+        {
+            int const k = segment_of(id);
+            return segments[k].load(memory_order_acquire)[id - segment_start(k)];
+        }
+
+        entry& slot(uint32_t id);
+};
+
+#endif
@@ -1,11 +1,41 @@
+import struct
 import sys
 from pathlib import Path
 
+import numpy as np
 import pandas as pd
 import matplotlib.pyplot as plt
 import seaborn as sns
 
 
+def read_results(path):
+    """Reads a results file: the binary columnar format if it starts with the magic, CSV otherwise."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if not data.startswith(b'CYCRES01'):
+        return pd.read_csv(path)
+    n_columns, = struct.unpack_from('<I', data, 8)
+    pos, columns = 16, []
+    for _ in range(n_columns):
+        kind, length = chr(data[pos]), data[pos + 1]
+        columns.append((data[pos + 2:pos + 2 + length].decode(), {'i': '<i8', 'u': '<u8', 'f': '<f8'}[kind]))
+        pos += 2 + length
+    chunks = {name: [] for name, _ in columns}
+    while pos < len(data):
+        rows, = struct.unpack_from('<Q', data, pos)
+        pos += 8
+        for name, dtype in columns:
+            chunks[name].append(np.frombuffer(data, dtype=dtype, count=rows, offset=pos))
+            pos += 8 * rows
+    frame = pd.DataFrame({name: np.concatenate(parts) if parts else np.array([], dtype=dtype)
+                          for (name, dtype), parts in zip(columns, chunks.values())})
+    # Values not measured are INT64_MIN, left empty in the CSV file
+    for name, dtype in columns:
+        if dtype == '<i8':
+            frame[name] = frame[name].mask(frame[name] == np.iinfo(np.int64).min)
+    return frame
+
+
 def plot_and_export(ax, filename_prefix):
     # Export to SVG and EPS formats
     for ext in ['svg', 'eps']:
@@ -24,10 +54,14 @@ else:
     logfile = 'filename.log'  # Configure your desired log file here, or pass it one the command line
 
 if logfile == 'filename.log':
-    print('Please set the logfile variable to a valid .log file')
+    print('Please set the logfile variable to a valid .log or .cols file')
     exit(1)
 
-df = pd.read_csv(logfile)
+df = read_results(logfile)
+
+# Rows after a batch of graph updates describe a different graph; plot the first search of each
+if 'batch' in df.columns:
+    df = df[df['batch'] == 0]
 
 # Calculate additional columns
 df['n_for_echo'] = df['n_for'] + df['n_echo']
@@ -109,3 +143,20 @@ ax4.tick_params(axis='both', which='major', labelsize=font_size)
 ax4.grid(True, zorder=1)  # Lower zorder for grid
 plt.tight_layout()
 plot_and_export(ax4, 'degree-vs-trace-messages')
+
+# Plot 5: Where the time goes, per phase, for logs that record phase timings
+phases = ['gen_ns', 'build_ns', 'msg_ns', 'cleanup_ns']
+if all(phase in df.columns for phase in phases):
+    fig, ax5 = plt.subplots(figsize=(7, 5))
+    totals = df_filtered.groupby('l')[phases].mean() / 1e9
+    bottom = np.zeros(len(totals))
+    for phase, color in zip(phases, sns.color_palette("colorblind", len(phases))):
+        ax5.bar(totals.index.astype(str), totals[phase], bottom=bottom, label=phase.removesuffix('_ns'), color=color, zorder=3)
+        bottom += totals[phase].to_numpy()
+    ax5.set_xlabel(r'max cycle length $\ell$', fontsize=font_size)
+    ax5.set_ylabel(r'avg time per run ($s$)', fontsize=font_size)
+    ax5.legend(fontsize=legend_font_size)
+    ax5.tick_params(axis='both', which='major', labelsize=font_size)
+    ax5.grid(True, axis='y', zorder=1)
+    plt.tight_layout()
+    plot_and_export(ax5, 'phase-breakdown')
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <immintrin.h>
+#include "powbatch.h"
+
+using namespace std;
+
+namespace
+{
+    struct simd_constants { uint64_t n, n_inv, r1, r2; };
+
+    __attribute__((target("avx2")))
+    __m256i mul_avx2(__m256i a, __m256i b, __m256i n, __m256i n_inv)
+    {
+        // a*b < 2^62 and m*n < 2^63, so the sum cannot overflow a 64-bit lane
+        __m256i const t  = _mm256_mul_epu32(a, b);
+        __m256i const m  = _mm256_mul_epu32(t, n_inv);
+        __m256i const u  = _mm256_srli_epi64(_mm256_add_epi64(t, _mm256_mul_epu32(m, n)), 32);
+        __m256i const lt = _mm256_cmpgt_epi64(n, u);
+        return _mm256_blendv_epi8(_mm256_sub_epi64(u, n), u, lt);
+    }
+
+    __attribute__((target("avx2")))
+    void pow_avx2(const simd_constants& c, const uint64_t *bases, const uint64_t *exps, uint64_t *out, size_t count)
+    {
+        __m256i const n     = _mm256_set1_epi64x((long long) c.n);
+        __m256i const n_inv = _mm256_set1_epi64x((long long) c.n_inv);
+        __m256i const r2    = _mm256_set1_epi64x((long long) c.r2);
+        __m256i const one   = _mm256_set1_epi64x(1);
+        for (size_t i = 0; i < count; i += 4)
+        {
+            size_t const lanes = min<size_t>(4, count - i);
+            alignas(32) uint64_t b[4] = {}, e[4] = {}, x[4];
+            copy_n(bases + i, lanes, b);
+            copy_n(exps + i, lanes, e);
+
+            __m256i a   = mul_avx2(_mm256_load_si256((__m256i*) b), r2, n, n_inv);
+            __m256i exp = _mm256_load_si256((__m256i*) e);
+            __m256i acc = _mm256_set1_epi64x((long long) c.r1);
+            // Right-to-left binary method, all lanes step through the longest exponent
+            for (uint64_t bits = e[0] | e[1] | e[2] | e[3]; bits != 0; bits >>= 1)
+            {
+                __m256i const set = _mm256_cmpeq_epi64(_mm256_and_si256(exp, one), one);
+                acc = _mm256_blendv_epi8(acc, mul_avx2(acc, a, n, n_inv), set);
+                a   = mul_avx2(a, a, n, n_inv);
+                exp = _mm256_srli_epi64(exp, 1);
+            }
+            _mm256_store_si256((__m256i*) x, mul_avx2(acc, one, n, n_inv));
+            copy_n(x, lanes, out + i);
+        }
+    }
+
+    __attribute__((target("avx512f,avx512ifma")))
+    __m512i mul_avx512(__m512i a, __m512i b, __m512i n, __m512i n_inv)
+    {
+        __m512i const zero = _mm512_setzero_si512();
+        __m512i const lo = _mm512_madd52lo_epu64(zero, a, b);
+        __m512i const hi = _mm512_madd52hi_epu64(zero, a, b);
+        __m512i const m  = _mm512_madd52lo_epu64(zero, lo, n_inv);
+        // lo + (m*n mod 2^52) is either 0 or exactly 2^52
+        __m512i const carry = _mm512_srli_epi64(_mm512_madd52lo_epu64(lo, m, n), 52);
+        __m512i const u = _mm512_add_epi64(_mm512_madd52hi_epu64(hi, m, n), carry);
+        return _mm512_mask_sub_epi64(u, _mm512_cmpge_epu64_mask(u, n), u, n);
+    }
+
+    __attribute__((target("avx512f,avx512ifma")))
+    void pow_avx512(const simd_constants& c, const uint64_t *bases, const uint64_t *exps, uint64_t *out, size_t count)
+    {
+        __m512i const n     = _mm512_set1_epi64((long long) c.n);
+        __m512i const n_inv = _mm512_set1_epi64((long long) c.n_inv);
+        __m512i const r2    = _mm512_set1_epi64((long long) c.r2);
+        __m512i const one   = _mm512_set1_epi64(1);
+        for (size_t i = 0; i < count; i += 8)
+        {
+            auto const mask = (__mmask8) ((1U << min<size_t>(8, count - i)) - 1);
+            __m512i a   = mul_avx512(_mm512_maskz_loadu_epi64(mask, bases + i), r2, n, n_inv);
+            __m512i exp = _mm512_maskz_loadu_epi64(mask, exps + i);
+            __m512i acc = _mm512_set1_epi64((long long) c.r1);
+            for (uint64_t bits = _mm512_reduce_or_epi64(exp); bits != 0; bits >>= 1)
+            {
+                __mmask8 const set = _mm512_test_epi64_mask(exp, one);
+                acc = _mm512_mask_mov_epi64(acc, set, mul_avx512(acc, a, n, n_inv));
+                a   = mul_avx512(a, a, n, n_inv);
+                exp = _mm512_srli_epi64(exp, 1);
+            }
+            _mm512_mask_storeu_epi64(out + i, mask, mul_avx512(acc, one, n, n_inv));
+        }
+    }
+
+    // -n^-1 mod 2^bits for odd n and bits < 64
+    uint64_t negated_inverse(uint64_t n, int bits)
+    {
+        uint64_t inv = n;
+        for (int i = 0; i < 5; ++i) inv *= 2 - n * inv;
+        return (0 - inv) & ((1ULL << bits) - 1);
+    }
+}
+
+const char* kernel_name(pow_kernel kernel)
+{
+    switch (kernel) {
+        case pow_kernel::avx2:   return "avx2";
+        case pow_kernel::avx512: return "avx512";
+        default:                 return "scalar";
+    }
+}
+
+bool pow_batcher::supported(pow_kernel kernel, uint64_t n)
+{
+    switch (kernel) {
+        case pow_kernel::avx2:   return n < (1ULL << 31) && __builtin_cpu_supports("avx2");
+        case pow_kernel::avx512: return n < (1ULL << 52) && __builtin_cpu_supports("avx512f")
+                                        && __builtin_cpu_supports("avx512ifma");
+        default:                 return true;
+    }
+}
+
+pow_kernel pow_batcher::best_kernel(uint64_t n)
+{
+    if (supported(pow_kernel::avx512, n)) return pow_kernel::avx512;
+    if (supported(pow_kernel::avx2, n)) return pow_kernel::avx2;
+    return pow_kernel::scalar;
+}
+
+pow_batcher::pow_batcher(uint64_t n, pow_kernel kernel) : k(kernel), mont(n), n(n)
+{
+    if (!supported(kernel, n)) k = pow_kernel::scalar;
+    if (k == pow_kernel::scalar) return;
+    int const bits = k == pow_kernel::avx2 ? 32 : 52;
+    n_inv = negated_inverse(n, bits);
+    r1 = (uint64_t) (((unsigned __int128) 1 << bits) % n);
+    r2 = (uint64_t) ((unsigned __int128) r1 * r1 % n);
+}
+
+void pow_batcher::operator()(span<const uint64_t> bases, span<const uint64_t> exps, span<uint64_t> out) const
+{
+    simd_constants const c{n, n_inv, r1, r2};
+    switch (k) {
+        case pow_kernel::avx2:
+            pow_avx2(c, bases.data(), exps.data(), out.data(), out.size());
+            break;
+        case pow_kernel::avx512:
+            pow_avx512(c, bases.data(), exps.data(), out.data(), out.size());
+            break;
+        default:
+            for (size_t i = 0; i < out.size(); ++i) out[i] = mont.from(mont.pow(mont.to(bases[i]), exps[i]));
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef POWBATCH_H
+#define POWBATCH_H
+
+#include <cstdint>
+#include <span>
+#include "modarith.h"
+
+using namespace std;
+
+// Kernels for batched exponentiation; the SIMD ones need a narrow enough modulus
+enum class pow_kernel
+{
+    scalar,     // sliding-window Montgomery, one lane at a time
+    avx2,       // 4 lanes of 32-bit Montgomery products, modulus < 2^31
+    avx512,     // 8 lanes of 52-bit Montgomery products via AVX-512 IFMA, modulus < 2^52
+};
+
+const char* kernel_name(pow_kernel);
+
+// Computes out[i] = bases[i]^exps[i] mod n over many independent lanes, using the widest kernel
+// that both the CPU (checked at runtime) and the modulus allow
+class pow_batcher
+{
+    public:
+        pow_batcher() = default;
+        explicit pow_batcher(uint64_t n) : pow_batcher(n, best_kernel(n)) {}
+        pow_batcher(uint64_t n, pow_kernel kernel);
+
+        static bool supported(pow_kernel kernel, uint64_t n);
+        static pow_kernel best_kernel(uint64_t n);
+
+        [[nodiscard]] pow_kernel kernel() const { return k; }
+
+        // Bases must be reduced mod n; out may alias neither input
+        void operator()(span<const uint64_t> bases, span<const uint64_t> exps, span<uint64_t> out) const;
+
+    private:
+        pow_kernel k = pow_kernel::scalar;
+        montgomery mont;        // scalar path
+        uint64_t n = 1;         // SIMD paths use R = 2^32 (avx2) or R = 2^52 (avx512)
+        uint64_t n_inv = 0;     // -n^-1 mod R
+        uint64_t r1 = 0;        // R mod n
+        uint64_t r2 = 0;        // R^2 mod n
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "clock.h"
+#include "profile.h"
+
+using namespace std;
+
+namespace
+{
+    const char *const probe_names[] = { "pow", "pow_g", "pow_batch", "random", "route_lookup", "publish_scan" };
+    const char *const tally_names[] = { "random_draws", "pow_lanes", "route_misses", "publish_links", "stale_links" };
+    const char *const type_names[] = { "forward", "backward", "publish", "broadcast" };
+    static_assert(size(probe_names) == (size_t) probe::count && size(tally_names) == (size_t) tally::count);
+
+    constexpr size_t top_nodes = 20;
+
+    // Every thread's profile; owned here so it outlives its thread
+    mutex registry_lock;
+    vector<unique_ptr<profile_data>> registry;
+
+    uint64_t& node_entry(vector<uint64_t>& by_node, int node)
+    {
+        if ((size_t) node >= by_node.size()) by_node.resize(max<size_t>((size_t) node + 1, 2 * by_node.size()));
+        return by_node[node];
+    }
+
+    int open_counter(uint32_t type, uint64_t config)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+profile_data& profile_local()
+{
+    thread_local profile_data *local = [] {
+        lock_guard lock(registry_lock);
+        registry.push_back(make_unique<profile_data>());
+        return registry.back().get();
+    }();
+    return *local;
+}
+
+profile_scope::~profile_scope()
+{
+    profile_data &data = profile_local();
+    data.probe_ns[(size_t) p] += nanoseconds_since(start);
+    ++data.probe_calls[(size_t) p];
+}
+
+profile_handler::~profile_handler()
+{
+    profile_data &data = profile_local();
+    auto const ns = (uint64_t) nanoseconds_since(start);
+    int const bucket = min(profile_data::buckets - 1, max(0, (int) bit_width(ns) - 1));
+    ++data.latency[type][bucket];
+    if (node >= 0) ++node_entry(data.node_messages, node);
+}
+
+void profile_state(int node, uint64_t entries)
+{
+    uint64_t &most = node_entry(profile_local().node_state, node);
+    most = max(most, entries);
+}
+
+hw_counters::hw_counters()
+{
+    const pair<const char *, pair<uint32_t, uint64_t>> wanted[] = {
+        { "cycles", { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES } },
+        { "instructions", { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS } },
+        { "cache_misses", { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES } },
+        { "branch_misses", { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES } },
+        { "task_clock_ns", { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK } },
+    };
+    for (const auto &[name, event] : wanted)
+    {
+        int const fd = open_counter(event.first, event.second);
+        if (fd >= 0) fds.emplace_back(name, fd);
+    }
+}
+
+hw_counters::~hw_counters()
+{
+    for (const auto &[_, fd] : fds) close(fd);
+}
+
+vector<pair<string, uint64_t>> hw_counters::read() const
+{
+    vector<pair<string, uint64_t>> values;
+    for (const auto &[name, fd] : fds)
+    {
+        uint64_t value = 0;
+        if (::read(fd, &value, sizeof(value)) == sizeof(value)) values.emplace_back(name, value);
+    }
+    return values;
+}
+
+void write_profile(const string& base, const vector<pair<string, uint64_t>>& hardware)
+{
+    profile_data total;
+    {
+        lock_guard lock(registry_lock);
+        for (const auto &data : registry)
+        {
+            for (size_t i = 0; i < total.probe_ns.size(); ++i)
+            {
+                total.probe_ns[i] += data->probe_ns[i];
+                total.probe_calls[i] += data->probe_calls[i];
+            }
+            for (size_t i = 0; i < total.tallies.size(); ++i) total.tallies[i] += data->tallies[i];
+            for (size_t t = 0; t < total.latency.size(); ++t)
+                for (int i = 0; i < profile_data::buckets; ++i) total.latency[t][i] += data->latency[t][i];
+            for (size_t v = 0; v < data->node_messages.size(); ++v) node_entry(total.node_messages, (int) v) += data->node_messages[v];
+            for (size_t v = 0; v < data->node_state.size(); ++v)
+            {
+                uint64_t &most = node_entry(total.node_state, (int) v);
+                most = max(most, data->node_state[v]);
+            }
+        }
+    }
+    size_t const nodes = max(total.node_messages.size(), total.node_state.size());
+    total.node_messages.resize(nodes);
+    total.node_state.resize(nodes);
+
+    ofstream json(base + ".profile.json", ofstream::trunc);
+    if (!json) throw runtime_error("cannot open " + base + ".profile.json");
+    json << "{\n  \"probes\": {";
+    for (size_t i = 0; i < total.probe_ns.size(); ++i)
+        json << (i ? ",\n" : "\n") << "    \"" << probe_names[i] << "\": { \"calls\": " << total.probe_calls[i] << ", \"ns\": " << total.probe_ns[i] << " }";
+    json << "\n  },\n  \"tallies\": {";
+    for (size_t i = 0; i < total.tallies.size(); ++i)
+        json << (i ? ",\n" : "\n") << "    \"" << tally_names[i] << "\": " << total.tallies[i];
+    json << "\n  },\n  \"handler_ns_log2_buckets\": {";
+    for (size_t t = 0; t < total.latency.size(); ++t)
+    {
+        json << (t ? ",\n" : "\n") << "    \"" << type_names[t] << "\": [";
+        for (int i = 0; i < profile_data::buckets; ++i) json << (i ? ", " : "") << total.latency[t][i];
+        json << "]";
+    }
+
+    vector<int> order(nodes);
+    iota(order.begin(), order.end(), 0);
+    size_t const shown = min(top_nodes, nodes);
+    partial_sort(order.begin(), order.begin() + (ptrdiff_t) shown, order.end(),
+                 [&](int a, int b) { return total.node_messages[a] > total.node_messages[b]; });
+    json << "\n  },\n  \"busiest_nodes\": [";
+    for (size_t i = 0; i < shown; ++i)
+        json << (i ? ",\n" : "\n") << "    { \"node\": " << order[i] << ", \"messages\": " << total.node_messages[order[i]]
+             << ", \"state\": " << total.node_state[order[i]] << " }";
+    json << "\n  ],\n  \"hardware\": {";
+    for (size_t i = 0; i < hardware.size(); ++i)
+        json << (i ? ",\n" : "\n") << "    \"" << hardware[i].first << "\": " << hardware[i].second;
+    json << "\n  }\n}\n";
+
+    ofstream csv(base + ".nodes.csv", ofstream::trunc);
+    if (!csv) throw runtime_error("cannot open " + base + ".nodes.csv");
+    csv << "node,messages,state\n";
+    for (size_t v = 0; v < nodes; ++v)
+        if (total.node_messages[v] || total.node_state[v]) csv << v << ',' << total.node_messages[v] << ',' << total.node_state[v] << '\n';
+    if (!json || !csv) throw runtime_error("cannot write profile of " + base);
+}
@@ -0,0 +1,110 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Hot-path instrumentation, compiled in with -DCYCLE_PROFILE=ON. Without it the PROFILE_ macros
+// expand to nothing, so the simulator pays nothing for them. Every thread records into its own
+// profile_data; write_profile() sums them once the threads are done.
+
+#ifdef CYCLE_PROFILE
+constexpr bool profile_enabled = true;
+#else
+constexpr bool profile_enabled = false;
+#endif
+
+// Timed sections; each also counts its calls
+enum class probe : uint8_t { pow, pow_g, pow_batch, random, route_lookup, publish_scan, count };
+
+// Plain event counters
+enum class tally : uint8_t { random_draws, pow_lanes, route_misses, publish_links, stale_links, count };
+
+struct profile_data
+{
+    static constexpr int buckets = 40;      // handler latency bucket i holds [2^i, 2^(i+1)) ns
+
+    array<uint64_t, (size_t) probe::count> probe_ns{}, probe_calls{};
+    array<uint64_t, (size_t) tally::count> tallies{};
+    array<array<uint64_t, buckets>, 4> latency{};   // per message type
+    vector<uint64_t> node_messages;     // messages handled, by node id
+    vector<uint64_t> node_state;        // most state entries held at once, by node id
+};
+
+// The calling thread's profile, registered for write_profile() on first use
+profile_data& profile_local();
+
+// Adds the time from construction to destruction to a probe
+class profile_scope
+{
+    public:
+        explicit profile_scope(probe p) : p(p), start(chrono::steady_clock::now()) {}
+        profile_scope(const profile_scope&) = delete;
+        profile_scope& operator=(const profile_scope&) = delete;
+        ~profile_scope();
+
+    private:
+        probe p;
+        chrono::steady_clock::time_point start;
+};
+
+// Times one message handler and charges the message to its target node; a negative node is not charged
+class profile_handler
+{
+    public:
+        profile_handler(int type, int node) : type(type), node(node), start(chrono::steady_clock::now()) {}
+        profile_handler(const profile_handler&) = delete;
+        profile_handler& operator=(const profile_handler&) = delete;
+        ~profile_handler();
+
+    private:
+        int type, node;
+        chrono::steady_clock::time_point start;
+};
+
+// Records that node held entries state entries at once, keeping the most seen
+void profile_state(int node, uint64_t entries);
+
+#ifdef CYCLE_PROFILE
+#define PROFILE_JOIN_(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_(a, b)
+#define PROFILE_SCOPE(p) profile_scope PROFILE_JOIN(profile_scope_, __LINE__)(p)
+#define PROFILE_COUNT(t, n) (profile_local().tallies[(size_t) (t)] += (n))
+#define PROFILE_HANDLER(type, node) profile_handler PROFILE_JOIN(profile_handler_, __LINE__)(type, node)
+#define PROFILE_STATE(node, entries) profile_state(node, entries)
+#else
+#define PROFILE_SCOPE(p) ((void) 0)
+#define PROFILE_COUNT(t, n) ((void) 0)
+#define PROFILE_HANDLER(type, node) ((void) 0)
+#define PROFILE_STATE(node, entries) ((void) 0)
+#endif
+
+// Hardware counters of this process and of every thread it starts afterwards, read through Linux
+// perf_event_open. A thread's counts are added when it exits, so read() after joining the workers.
+// Counters the kernel refuses, e.g. under a strict perf_event_paranoid, are left out.
+class hw_counters
+{
+    public:
+        hw_counters();
+        hw_counters(const hw_counters&) = delete;
+        hw_counters& operator=(const hw_counters&) = delete;
+        ~hw_counters();
+
+        // Name and value of every counter that could be opened
+        [[nodiscard]] vector<pair<string, uint64_t>> read() const;
+
+    private:
+        vector<pair<string, int>> fds;
+};
+
+// Writes base.profile.json with the probes, tallies, handler latency histograms, the busiest nodes
+// and any hardware counters, and base.nodes.csv with the load of every node. Node ids are summed
+// over all graphs of the sweep, so the node file is most telling for a single graph.
+void write_profile(const string& base, const vector<pair<string, uint64_t>>& hardware = {});
+
+#endif
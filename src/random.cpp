@@ -0,0 +1,94 @@
+#include <atomic>
+#include <mutex>
+#include "random.h"
+
+using namespace std;
+
+namespace
+{
+    atomic<uint64_t> master_seed{0};
+    atomic<bool>     master_seed_set{false};
+    atomic<uint64_t> next_stream{0};
+
+    uint64_t seedFor(uint64_t stream)
+    {
+        uint64_t state = getMasterSeed() ^ (stream * 0x9E3779B97F4A7C15ULL);
+        return splitmix64(state);
+    }
+
+    engine& localEngine(bool fresh, uint64_t stream)
+    {
+        // Implicit per-thread streams live in the upper half so they never alias explicit ones
+        thread_local engine gen(seedFor(next_stream.fetch_add(1) | (1ULL << 63)));
+        if (fresh) gen = engine(seedFor(stream));
+        return gen;
+    }
+}
+
+uint64_t splitmix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+xoshiro256::xoshiro256(uint64_t seed)
+{
+    for (auto &word : s) word = splitmix64(seed);
+}
+
+void setMasterSeed(uint64_t seed)
+{
+    master_seed.store(seed);
+    master_seed_set.store(true);
+    next_stream.store(0);
+}
+
+uint64_t getMasterSeed()
+{
+    static once_flag drawn;
+    call_once(drawn, [] {
+        if (master_seed_set.load()) return;
+        random_device rd;
+        master_seed.store(((uint64_t) rd() << 32) | rd());
+        master_seed_set.store(true);
+    });
+    return master_seed.load();
+}
+
+const char *engineName()
+{
+#ifdef CYCLE_RNG_MT19937
+    return "mt19937_64";
+#else
+    return "xoshiro256**";
+#endif
+}
+
+engine& threadEngine() { return localEngine(false, 0); }
+
+void reseedThread(uint64_t stream) { localEngine(true, stream); }
+
+uint64_t getRandomBelow(uint64_t bound)
+{
+    // Lemire's nearly divisionless method
+    engine &gen = threadEngine();
+    auto m = (unsigned __int128) gen() * bound;
+    auto low = (uint64_t) m;
+    if (low < bound)
+    {
+        uint64_t const threshold = -bound % bound;
+        while (low < threshold)
+        {
+            m = (unsigned __int128) gen() * bound;
+            low = (uint64_t) m;
+        }
+    }
+    return (uint64_t) (m >> 64);
+}
+
+void fillRandomBelow(uint64_t bound, span<uint64_t> out)
+{
+    for (auto &v : out) v = getRandomBelow(bound);
+}
@@ -0,0 +1,66 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <random>
+#include <span>
+
+using namespace std;
+
+// xoshiro256** by Blackman and Vigna; small state, fast, good statistical quality
+class xoshiro256
+{
+    public:
+        using result_type = uint64_t;
+
+        explicit xoshiro256(uint64_t seed = 0);
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+
+        result_type operator()()
+        {
+            uint64_t const result = rotl(s[1] * 5, 7) * 9;
+            uint64_t const t = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = rotl(s[3], 45);
+            return result;
+        }
+
+    private:
+        uint64_t s[4]{};
+
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// The generator used by all random draws, chosen at compile time
+#ifdef CYCLE_RNG_MT19937
+using engine = mt19937_64;
+#else
+using engine = xoshiro256;
+#endif
+
+uint64_t splitmix64(uint64_t&);
+
+// Name of the generator, so records of random draws can tell whether they can be repeated
+const char *engineName();
+
+// Master seed from which every thread derives its own stream; drawn from random_device unless set
+void setMasterSeed(uint64_t);
+uint64_t getMasterSeed();
+
+// The calling thread's engine, seeded once on first use
+engine& threadEngine();
+
+// Reseeds the calling thread's engine with a stream derived deterministically from the master seed
+void reseedThread(uint64_t stream);
+
+// Uniform draw in [0, bound) without modulo bias
+uint64_t getRandomBelow(uint64_t bound);
+void fillRandomBelow(uint64_t bound, span<uint64_t> out);
+
+#endif
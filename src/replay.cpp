@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "clock.h"
+#include "engine.h"
+#include "random.h"
+#include "trace.h"
+
+using namespace std;
+
+namespace
+{
+    // Replays the run repeats times and prints its counts and the fastest delivery
+    template<group_backend G>
+    void replay_run(const trace_run& run, const G& grp, replay_mode mode, int repeats)
+    {
+        basic_simulation<G> sim(run.topology, grp, run.seed);
+        run_stats stats;
+        int64_t best_ns = INT64_MAX;
+        for (int k = 0; k < repeats; ++k)
+        {
+            auto t0 = chrono::steady_clock::now();
+            stats = replay(sim, run, mode);
+            int64_t const ns = nanoseconds_since(t0);
+            best_ns = min(best_ns, ns - stats.trace_decode_ns - stats.cleanup_ns);
+        }
+        if ((size_t) stats.messages != run.messages() && run.shortest == run.l)
+            throw runtime_error("replay: counted " + to_string(stats.messages) + " messages, the trace has " + to_string(run.messages()));
+        cout << fixed << setprecision(2)
+             << "group=" << run.backend << ", n=" << run.topology.size() << ", m=" << run.topology.edges() << ", l=" << run.l
+             << ", n_cyc=" << stats.cycles.raw() << " (" << stats.cycles.unique() << " unique), n_msg=" << stats.messages
+             << ", trace=" << (double) run.bytes() / (double) max<size_t>(run.messages(), 1) << "B/msg"
+             << ", t=" << (double) best_ns / 1e6 << "ms, " << (int64_t) (1e9 * (double) run.messages() / (double) max<int64_t>(best_ns, 1)) << " msgs/s"
+             << ", decode=" << (double) stats.trace_decode_ns / (double) max<size_t>(run.messages(), 1) << "ns/msg" << endl;
+    }
+}
+
+// Replays the runs of a trace file recorded with trace=<file>: handlers redoes the nodes' work in the
+// recorded order, dispatch only moves the messages through the engine's queue. Both take the best of
+// the repeats and leave out decoding the trace and releasing instance state.
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 4)
+    {
+        cerr << "usage: " << argv[0] << " <trace> [handlers|dispatch [repeats]]" << endl;
+        return 1;
+    }
+    try
+    {
+        replay_mode const mode = argc > 2 ? parse_replay_mode(argv[2]) : replay_mode::handlers;
+        int const repeats = argc > 3 ? max(1, stoi(argv[3])) : 1;
+        for (const trace_run &run : load_trace(argv[1]))
+        {
+            setMasterSeed(run.master_seed);
+            switch (parse_group_kind(run.backend))
+            {
+                case group_kind::small: replay_run(run, small_group(group(run.p, run.q, run.r, run.h, run.g)), mode, repeats); break;
+                case group_kind::modp2048: replay_run(run, modp2048::rfc3526(), mode, repeats); break;
+                case group_kind::modp3072: replay_run(run, modp3072::rfc3526(), mode, repeats); break;
+                default: replay_run(run, group(run.p, run.q, run.r, run.h, run.g), mode, repeats); break;
+            }
+        }
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
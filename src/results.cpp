@@ -0,0 +1,165 @@
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include "results.h"
+
+using namespace std;
+
+namespace
+{
+    struct column
+    {
+        const char *name;
+        char type;          // 'i' int64, 'u' uint64, 'f' float64
+        size_t offset;
+    };
+
+    // Every column in row order; all values are 8 bytes wide
+    const column columns[] = {
+        { "n", 'i', offsetof(result_row, n) },
+        { "m", 'i', offsetof(result_row, m) },
+        { "d_avg", 'f', offsetof(result_row, d_avg) },
+        { "l", 'i', offsetof(result_row, l) },
+        { "n_cyc", 'i', offsetof(result_row, n_cyc) },
+        { "c_edge", 'i', offsetof(result_row, c_edge) },
+        { "n_msg", 'i', offsetof(result_row, n_msg) },
+        { "n_for", 'i', offsetof(result_row, n_for) },
+        { "n_echo", 'i', offsetof(result_row, n_echo) },
+        { "n_pub", 'i', offsetof(result_row, n_pub) },
+        { "n_brd", 'i', offsetof(result_row, n_brd) },
+        { "t", 'i', offsetof(result_row, t) },
+        { "mem", 'i', offsetof(result_row, mem) },
+        { "rounds", 'i', offsetof(result_row, rounds) },
+        { "iteration", 'i', offsetof(result_row, iteration) },
+        { "graph_seed", 'u', offsetof(result_row, graph_seed) },
+        { "seed", 'u', offsetof(result_row, seed) },
+        { "gen_ns", 'i', offsetof(result_row, gen_ns) },
+        { "build_ns", 'i', offsetof(result_row, build_ns) },
+        { "msg_ns", 'i', offsetof(result_row, msg_ns) },
+        { "cleanup_ns", 'i', offsetof(result_row, cleanup_ns) },
+        { "n_cyc_unique", 'i', offsetof(result_row, n_cyc_unique) },
+        { "known_edges", 'i', offsetof(result_row, known_edges) },
+        { "known_node_bytes", 'f', offsetof(result_row, known_node_bytes) },
+        { "flood_l", 'i', offsetof(result_row, flood_l) },
+        { "batch", 'i', offsetof(result_row, batch) },
+        { "updates", 'i', offsetof(result_row, updates) },
+        { "reruns", 'i', offsetof(result_row, reruns) },
+        { "rerun_msg", 'i', offsetof(result_row, rerun_msg) },
+        { "wire_msg", 'i', offsetof(result_row, wire_msg) },
+        { "wire_bytes", 'i', offsetof(result_row, wire_bytes) },
+        { "encode_ns", 'i', offsetof(result_row, encode_ns) },
+        { "decode_ns", 'i', offsetof(result_row, decode_ns) },
+        { "transfer_ns", 'i', offsetof(result_row, transfer_ns) },
+        { "sim_ns", 'i', offsetof(result_row, sim_ns) },
+        { "sim_mean_ns", 'i', offsetof(result_row, sim_mean_ns) },
+        { "sim_p99_ns", 'i', offsetof(result_row, sim_p99_ns) },
+        { "p_bits", 'i', offsetof(result_row, p_bits) },
+    };
+    static_assert(sizeof(result_row) == sizeof(columns) / sizeof(column) * 8, "every field of result_row is a column");
+
+    constexpr char magic[8] = { 'C', 'Y', 'C', 'R', 'E', 'S', '0', '1' };
+    constexpr size_t csv_buffer_bytes = 1 << 16;
+
+    string csv_value(const result_row& row, const column& c)
+    {
+        const char *field = (const char *) &row + c.offset;
+        switch (c.type)
+        {
+            case 'f': return isnan(*(const double *) field) ? "" : to_string(*(const double *) field);
+            case 'u': return to_string(*(const uint64_t *) field);
+            default: return *(const int64_t *) field == not_measured ? "" : to_string(*(const int64_t *) field);
+        }
+    }
+}
+
+result_format parse_result_format(const string& name)
+{
+    if (name == "csv") return result_format::csv;
+    if (name == "binary") return result_format::binary;
+    if (name == "both") return result_format::both;
+    throw invalid_argument("format must be csv, binary or both, not " + name);
+}
+
+result_writer::result_writer(const string& base, result_format format) : format(format), last_flush(chrono::steady_clock::now())
+{
+    if (format != result_format::binary)
+    {
+        csv.open(base + ".log", ofstream::app);
+        if (!csv) throw runtime_error("cannot open " + base + ".log");
+        for (const column &c : columns) csv_buffer += string(csv_buffer.empty() ? "" : ",") + c.name;
+        csv_buffer += '\n';
+    }
+    if (format != result_format::csv)
+    {
+        binary.open(base + ".cols", ofstream::binary | ofstream::trunc);
+        if (!binary) throw runtime_error("cannot open " + base + ".cols");
+        uint32_t const header[2] = { sizeof(columns) / sizeof(column), 0 };
+        binary.write(magic, sizeof(magic));
+        binary.write((const char *) header, sizeof(header));
+        for (const column &c : columns)
+        {
+            auto const length = (uint8_t) strlen(c.name);
+            binary.put(c.type);
+            binary.put((char) length);
+            binary.write(c.name, length);
+        }
+    }
+    flush_locked();
+}
+
+result_writer::~result_writer()
+{
+    lock_guard lock(m);
+    try { flush_locked(); } catch (const exception&) {}     // nowhere left to report a failed write
+}
+
+void result_writer::write(const result_row& row)
+{
+    lock_guard lock(m);
+    if (format != result_format::binary)
+    {
+        for (const column &c : columns) csv_buffer += (&c == columns ? "" : ",") + csv_value(row, c);
+        csv_buffer += '\n';
+    }
+    if (format != result_format::csv) pending.push_back(row);
+
+    if (csv_buffer.size() >= csv_buffer_bytes || pending.size() >= group_rows
+        || chrono::steady_clock::now() - last_flush >= chrono::seconds(1))
+        flush_locked();
+}
+
+void result_writer::flush()
+{
+    lock_guard lock(m);
+    flush_locked();
+}
+
+void result_writer::flush_locked()
+{
+    last_flush = chrono::steady_clock::now();
+    if (csv.is_open() && !csv_buffer.empty())
+    {
+        csv.write(csv_buffer.data(), (streamsize) csv_buffer.size());
+        csv.flush();
+        csv_buffer.clear();
+    }
+    if (binary.is_open() && !pending.empty())
+    {
+        // Transpose the row group into one contiguous array per column
+        uint64_t const rows = pending.size();
+        vector<char> block(sizeof(rows) + rows * sizeof(columns) / sizeof(column) * 8);
+        memcpy(block.data(), &rows, sizeof(rows));
+        char *out = block.data() + sizeof(rows);
+        for (const column &c : columns)
+            for (const result_row &row : pending)
+            {
+                memcpy(out, (const char *) &row + c.offset, 8);
+                out += 8;
+            }
+        binary.write(block.data(), (streamsize) block.size());
+        binary.flush();
+        pending.clear();
+    }
+    if ((csv.is_open() && !csv) || (binary.is_open() && !binary)) throw runtime_error("cannot write results");
+}
@@ -0,0 +1,91 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Values a row has no measurement for; the CSV file leaves their fields empty
+constexpr int64_t not_measured = INT64_MIN;
+constexpr double not_measured_f = numeric_limits<double>::quiet_NaN();
+
+// One row of experiment results: a graph searched for cycles of length up to l
+struct result_row
+{
+    int64_t n = 0, m = 0;
+    double d_avg = 0;
+    int64_t l = 0;
+    int64_t n_cyc = 0, c_edge = 0;
+    int64_t n_msg = 0, n_for = 0, n_echo = 0, n_pub = 0, n_brd = 0;
+    int64_t t = 0;                  // wall-clock milliseconds of the run
+    int64_t mem = 0;                // peak protocol state live at once, in bytes
+    int64_t rounds = 0;
+    int64_t iteration = 0;
+    uint64_t graph_seed = 0, seed = 0;
+    int64_t gen_ns = 0;             // generating or loading the graph, shared by all rows of the graph
+    int64_t build_ns = 0;           // constructing the simulations
+    int64_t msg_ns = 0;             // processing messages: the run without its cleanup
+    int64_t cleanup_ns = 0;         // releasing instance state, summed over workers, and tearing down
+    int64_t n_cyc_unique = 0;       // n_cyc counts rotations of a cycle separately, this does not
+    int64_t known_edges = 0;        // distinct edges the nodes learned from the broadcasts
+    double known_node_bytes = 0;    // memory of the learned topology per node
+    int64_t flood_l = 0;            // length flooded to count the row, above l in a single pass
+    int64_t batch = 0;              // batch of graph updates the row follows, 0 for the first search
+    int64_t updates = 0;            // updates of the batch that changed the graph
+    int64_t reruns = 0;             // instances run for the row, all n unless it follows a batch
+    int64_t rerun_msg = 0;          // messages they sent; n_msg is what a full recompute sends
+    int64_t wire_msg = 0;           // messages carried by the transport
+    int64_t wire_bytes = 0;         // their encoded size, 0 in process
+    int64_t encode_ns = 0;          // encoding and decoding them, summed over workers
+    int64_t decode_ns = 0;
+    int64_t transfer_ns = 0;        // round trips through the relay process, summed over workers
+    int64_t sim_ns = 0;             // simulated time until every instance completed, event engine only
+    int64_t sim_mean_ns = 0;        // simulated completion time of the average instance
+    int64_t sim_p99_ns = 0;         // and of the 99th percentile
+    int64_t p_bits = 0;             // size of the group's modulus
+};
+
+enum class result_format { csv, binary, both };
+
+// Writes result rows to a CSV file, a binary columnar file or both, keeping them open and buffering
+// rows in memory. Buffers are written out once they hold a row group, after a second has passed,
+// on flush() and on destruction. Safe for concurrent writers.
+//
+// The binary file starts with the magic "CYCRES01", the column count as a uint32 and four zero
+// bytes, then per column a type byte ('i' int64, 'u' uint64, 'f' float64), a name length byte and
+// the name. Row groups follow: a uint64 row count, then each column's values as 8-byte host-order
+// numbers, column after column. Values not measured are INT64_MIN or NaN there.
+class result_writer
+{
+    public:
+        // Paths are formed by appending ".log" for CSV and ".cols" for the binary file to base
+        result_writer(const string& base, result_format format);
+        result_writer(const result_writer&) = delete;
+        result_writer& operator=(const result_writer&) = delete;
+        ~result_writer();
+
+        void write(const result_row& row);
+        void flush();
+
+        static constexpr size_t group_rows = 1024;
+
+    private:
+        mutex m;
+        result_format format;
+        ofstream csv, binary;
+        string csv_buffer;
+        vector<result_row> pending;     // rows of the binary row group being filled
+        chrono::steady_clock::time_point last_flush;
+
+        void flush_locked();
+};
+
+result_format parse_result_format(const string&);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Growable FIFO over a power-of-two circular array; front() is processed in place and the
+// storage is kept across clear() so a warmed-up queue never allocates
+template <typename T>
+class ring_buffer
+{
+    public:
+        [[nodiscard]] bool empty() const { return head == tail; }
+        [[nodiscard]] size_t size() const { return tail - head; }
+
+        T& front() { return items[head & mask]; }
+        const T& front() const { return items[head & mask]; }
+
+        void push_back(const T& item)
+        {
+            if (size() == items.size()) grow();
+            items[tail++ & mask] = item;
+        }
+
+        void pop_front() { ++head; }
+
+        void clear() { head = tail = 0; }
+
+    private:
+        vector<T> items;
+        size_t head = 0;    // both indices only grow, the slot is index & mask
+        size_t tail = 0;
+        size_t mask = 0;
+
+        void grow()
+        {
+            vector<T> larger(max<size_t>(16, items.size() * 2));
+            for (size_t i = head; i != tail; ++i) larger[i - head] = std::move(items[i & mask]);
+            tail -= head;
+            head = 0;
+            items = std::move(larger);
+            mask = items.size() - 1;
+        }
+};
+
+#endif
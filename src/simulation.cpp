@@ -0,0 +1,97 @@
+#include <algorithm>
+#include "profile.h"
+#include "simulation.h"
+
+using namespace std;
+
+template<group_backend G>
+basic_simulation<G>::basic_simulation(const graph& topology, const G& grp, uint64_t seed, int shards)
+    : node_count(topology.size()), instance_seed(seed), topology(topology), grp(grp), slot_of(topology.size(), basic_node_states<G>::none),
+      link(make_transport<G>(transport_kind::in_process))
+{
+    for (int k = 0; k < max(shards, 1); ++k) arenas.push_back(make_unique<arena>());
+    for (auto &a : arenas) states.emplace_back(a.get());
+}
+
+template<group_backend G>
+basic_node<G> basic_simulation<G>::at(int id)
+{
+    basic_node_states<G> &shard = states[shard_of(id)];
+    if (slot_of[id] == basic_node_states<G>::none) slot_of[id] = shard.add(id);
+    return { id, topology.neighbours(id), shard, slot_of[id], grp, &publish_paths, shortest };
+}
+
+template<group_backend G>
+void basic_simulation<G>::initiate(int id, int l, vector<message>& out)
+{
+    longest = l;
+    at(id).initiate(l, out);
+}
+
+template<group_backend G>
+void basic_simulation<G>::send(const message& msg, vector<message>& out)
+{
+    PROFILE_HANDLER(msg.t, msg.t == broadcast ? -1 : msg.target);
+    switch (msg.t) {
+        case f: at(msg.target).forward(msg, out); break;
+        case b: at(msg.target).backward(msg, out); break;
+        case p: at(msg.target).publish(msg, out); break;
+        case broadcast: deliver_broadcasts({ &msg, 1 }); break;
+        default: break;
+    }
+}
+
+template<group_backend G>
+void basic_simulation<G>::deliver_broadcasts(span<const message> batch)
+{
+    // Broadcasts keep no instance state, so they claim no slots. Those a single pass only sends for
+    // shorter lengths teach nothing a search of its own length would.
+    for (const message &msg : batch)
+        if (msg.valid_to >= longest) known.learn(publish_paths, msg.path);
+}
+
+template<group_backend G>
+void basic_simulation<G>::end_instance()
+{
+    for (auto &shard : states)
+    {
+        if constexpr (profile_enabled)
+            for (size_t i = 0; i < shard.size(); ++i)
+                PROFILE_STATE(shard.ids[i], shard.keys[i].size() + shard.init[i].size() + shard.routes[i].size() + shard.publish_links[i].size());
+        for (int id : shard.ids) slot_of[id] = basic_node_states<G>::none;
+        shard.clear();
+    }
+    publish_paths.clear();
+    for (auto &a : arenas) a->rewind();
+}
+
+template<group_backend G>
+void basic_simulation<G>::reset()
+{
+    end_instance();
+    known.clear();
+    link->reset_stats();
+    for (auto &a : arenas) a->reset_peak();
+}
+
+template<group_backend G>
+size_t basic_simulation<G>::peak_bytes() const
+{
+    // Shards peak at different moments, so the sum is an upper bound when there are several
+    size_t total = 0;
+    for (const auto &a : arenas) total += a->peak();
+    return total;
+}
+
+template<group_backend G>
+size_t basic_simulation<G>::bytes() const
+{
+    size_t total = slot_of.capacity() * sizeof(uint32_t);
+    for (const auto &shard : states) total += shard.bytes();
+    return total;
+}
+
+template class basic_simulation<small_group>;
+template class basic_simulation<group>;
+template class basic_simulation<modp2048>;
+template class basic_simulation<modp3072>;
@@ -0,0 +1,108 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "arena.h"
+#include "graph.h"
+#include "group.h"
+#include "message.h"
+#include "node.h"
+#include "path.h"
+#include "transport.h"
+#include "wire.h"
+
+using namespace std;
+
+// Runs the protocol on one graph, which must outlive it. Node state is kept per shard in struct-of-arrays
+// form and only for the nodes an instance touched: slot_of maps a node id to its slot in its shard's
+// arrays. Each initiator's instance runs between initiate() and end_instance(), which releases its state.
+//
+// Nodes are split into contiguous shards, each with its own arena and state arrays, so that
+// different shards may be driven from different threads at the same time.
+template<group_backend G>
+class basic_simulation
+{
+    public:
+        using message = basic_message<G>;
+
+        basic_simulation(const graph& topology, const G& grp, uint64_t seed, int shards = 1);
+        basic_simulation(const basic_simulation&) = delete;
+        basic_simulation& operator=(const basic_simulation&) = delete;
+
+        [[nodiscard]] int size() const { return node_count; }
+
+        // Seed the random stream of every instance on this graph is derived from
+        [[nodiscard]] uint64_t seed() const { return instance_seed; }
+
+        [[nodiscard]] int shards() const { return (int) arenas.size(); }
+        [[nodiscard]] int shard_begin(int k) const { return (int) ((int64_t) k * size() / shards()); }
+        [[nodiscard]] int shard_of(int id) const { return (int) (((int64_t) id + 1) * shards() - 1) / size(); }
+
+        void initiate(int id, int l, vector<message>& out);
+
+        // Shortest search length whose messages the nodes still send when a longer search has made
+        // them stale; searches of length l set it to l, one standing in for all lengths down to
+        // some l' sets it to l'
+        void set_shortest(int l) { shortest = l; }
+
+        // Sends the appropriate message based on the message type, appending the replies to out
+        void send(const message& msg, vector<message>& out);
+
+        // Carries the messages of out from index from on through the transport, which may replace
+        // them with decoded copies; the engines call it on everything initiate() and send() emit
+        void carry(vector<message>& out, size_t from = 0) { link->carry(out, from, publish_paths); }
+
+        // Decodes a wire-encoded message into this simulation's path store, as a relayed transport's
+        // copy would be, so the handlers can follow its path
+        message decode(span<const uint8_t>& in) { return ::decode<G>(in, publish_paths); }
+
+        // Replaces the in-process transport every simulation starts with
+        void set_transport(unique_ptr<basic_transport<G>> t) { link = std::move(t); }
+        [[nodiscard]] const basic_transport<G>& channel() const { return *link; }
+
+        // Delivers a batch of broadcasts to every node at once
+        void deliver_broadcasts(span<const message> batch);
+
+        // Edges the nodes learned since the last reset from broadcasts a search of the initiated
+        // length sends
+        [[nodiscard]] const known_topology& learned() const { return known; }
+
+        [[nodiscard]] const path_store& paths() const { return publish_paths; }
+
+        // Releases the state of every node the current instance touched and rewinds the arenas
+        void end_instance();
+
+        // Starts a fresh run: clears all instance state, the learned topology, the peak statistic
+        // and the transport's counters
+        void reset();
+
+        // Highest number of bytes of protocol state held at once since the last reset
+        [[nodiscard]] size_t peak_bytes() const;
+
+        // Bytes held outside the arenas: the slot index and the state arrays of every shard
+        [[nodiscard]] size_t bytes() const;
+
+    private:
+        int node_count;
+        uint64_t instance_seed;
+        vector<unique_ptr<arena>> arenas;   // one per shard, created before the state arrays allocate from them
+        path_store publish_paths;           // paths of the current instance
+        const graph &topology;
+        G grp;
+        vector<basic_node_states<G>> states;    // per shard
+        vector<uint32_t> slot_of;           // node id -> slot in its shard's states, or none
+        known_topology known;               // shared by all nodes, kept across instances
+        unique_ptr<basic_transport<G>> link;
+        int shortest = 0;
+        int longest = 0;                    // length the current instances search for
+
+        // The node with the given id, given a state slot if the current instance had not touched it yet
+        basic_node<G> at(int id);
+};
+
+using simulation = basic_simulation<group>;
+
+#endif
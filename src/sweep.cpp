@@ -0,0 +1,493 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <fstream>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "clock.h"
+#include "dynamic.h"
+#include "engine.h"
+#include "graph_io.h"
+#include "random.h"
+#include "sweep.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    // Seed of the thing at the given coordinates, mixed into the master seed one coordinate at a time
+    uint64_t derive_seed(uint64_t master, initializer_list<uint64_t> coordinates)
+    {
+        uint64_t state = master;
+        for (uint64_t c : coordinates)
+        {
+            state ^= c;
+            state = splitmix64(state);
+        }
+        return state;
+    }
+
+    // One graph of the sweep, built by the first of its cells to run and dropped after the last
+    struct graph_job
+    {
+        int iteration, n, d;
+        uint64_t seed;
+        once_flag built;
+        unique_ptr<graph> topology;
+        int m = 0;
+        double d_avg = 0;
+        int64_t gen_ns = 0;
+        atomic<int> remaining{0};
+    };
+
+    // Searches the job's graph with length l, standing in for every length down to shortest
+    struct cell
+    {
+        graph_job *job;
+        int l;
+        int shortest;
+    };
+
+    string trim(const string& s)
+    {
+        size_t const first = s.find_first_not_of(" \t\r");
+        if (first == string::npos) return "";
+        return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+    }
+
+    uint64_t cell_seed(uint64_t master, const cell& c)
+    {
+        return derive_seed(master, { 1, (uint64_t) c.job->iteration, (uint64_t) c.job->n, (uint64_t) c.job->d, (uint64_t) c.l });
+    }
+
+    mutex print;
+    mutex trace_lock;
+
+    template<group_backend G>
+    int modulus_bits(const G& grp)
+    {
+        if constexpr (is_same_v<typename G::element, uint64_t>) return bit_width(grp.p);
+        else return grp.p.bit_width();
+    }
+
+    // The row fields every row of a cell shares
+    template<group_backend G>
+    result_row cell_row(const G& grp, const graph_job& job, const cell& c, uint64_t seed, int64_t build_ns)
+    {
+        result_row row;
+        row.p_bits = modulus_bits(grp);
+        row.n = job.n;
+        row.m = job.m;
+        row.d_avg = job.d_avg;
+        row.l = c.l;
+        row.flood_l = c.l;
+        row.iteration = job.iteration;
+        row.graph_seed = job.seed;
+        row.seed = seed;
+        row.gen_ns = job.gen_ns;
+        row.build_ns = build_ns;
+        row.reruns = job.n;
+        return row;
+    }
+
+    // The summary line printed for a row
+    template<group_backend G>
+    string describe(const sweep_config& config, const result_row& row, size_t collisions)
+    {
+        ostringstream line;
+        line << fixed << setprecision(2)
+             << "n="      << row.n << ", "
+             << "m="      << row.m << ", "
+             << "d_avg="  << row.d_avg << ", "
+             << "l="      << row.l << ", "
+             << "n_cyc="  << row.n_cyc << " (" << row.n_cyc_unique << " unique), "
+             << "c_edge=" << row.c_edge << ", "
+             << "n_msg="  << row.n_msg << ", "
+             << "n_for="  << row.n_for << ", "
+             << "n_echo=" << row.n_echo << ", "
+             << "n_pub="  << row.n_pub << ", "
+             << "n_brd="  << row.n_brd << ", "
+             << "t="      << row.t << "ms (" << row.t / 1000 << "s)";
+        if (row.mem != not_measured)
+            line << ", mem=" << row.mem << "B, known=" << row.known_edges << " edges (" << row.known_node_bytes << "B/node)";
+        if (config.rounds) line << ", rounds=" << row.rounds;
+        if (config.events)
+            line << ", sim=" << (double) row.sim_ns / 1000 << "us (mean " << (double) row.sim_mean_ns / 1000 << "us, p99 "
+                 << (double) row.sim_p99_ns / 1000 << "us), " << 1e3 * (double) row.n_msg / (double) max<int64_t>(row.msg_ns, 1) << "M events/s";
+        if (config.check_cycles) line << ", collisions=" << collisions;
+        if (row.flood_l > row.l) line << ", flood_l=" << row.flood_l;
+        if (config.transport != transport_kind::in_process)
+        {
+            auto const msgs = (double) max<int64_t>(row.wire_msg, 1);
+            line << ", " << transport_name(config.transport) << "=" << (double) row.wire_bytes / msgs << "B/msg ("
+                 << sizeof(basic_message<G>) << "B in memory), ser=" << (double) (row.encode_ns + row.decode_ns) / msgs << "ns/msg, "
+                 << "xfer=" << (double) row.transfer_ns / msgs << "ns/msg, "
+                 << 1e3 * (double) row.wire_msg / (double) max<int64_t>(row.transfer_ns, 1) << "M msgs/s";
+        }
+        if (row.batch > 0)
+            line << ", batch=" << row.batch << " (" << row.updates << " updates, " << row.reruns << " reruns, "
+                 << row.rerun_msg << " msgs, " << 100.0 * (1.0 - (double) row.rerun_msg / max<int64_t>(row.n_msg, 1)) << "% saved)";
+        return line.str();
+    }
+
+    // Runs one cell on the given pool and writes its row
+    template<group_backend G>
+    void run_cell(const sweep_config& config, const G& grp, thread_pool& pool, result_writer& results, const cell& c)
+    {
+        graph_job &job = *c.job;
+        uint64_t const seed = cell_seed(config.seed, c);
+        auto t0 = chrono::steady_clock::now();
+
+        // The fifo engine gets one replica per worker, so concurrent instances never share node
+        // state; the round engine runs everything on one simulation, sharded across the workers
+        vector<unique_ptr<basic_simulation<G>>> replicas;
+        unsigned const copies = config.rounds ? 1 : pool.size();
+        int const shards = config.rounds ? 4 * (int) pool.size() : 1;
+        for (unsigned w = 0; w < copies; ++w)
+        {
+            replicas.push_back(make_unique<basic_simulation<G>>(*job.topology, grp, seed, shards));
+            replicas.back()->set_transport(make_transport<G>(config.transport));
+        }
+        int64_t const build_ns = nanoseconds_since(t0);
+
+        auto t1 = chrono::steady_clock::now();
+        run_options options;
+        options.shortest = c.shortest;
+        options.check_cycles = config.check_cycles;
+        // Edge latencies belong to the graph, so every length of it sees the same network
+        latency_model latency{ config.latency, config.jitter, derive_seed(config.seed, { 3, (uint64_t) job.iteration, (uint64_t) job.n, (uint64_t) job.d }) };
+        if (config.events) options.latency = &latency;
+        unique_ptr<trace_run> trace;
+        if (!config.trace_file.empty())
+        {
+            trace = make_unique<trace_run>(group_name(config.backend), *job.topology, seed, c.l, c.shortest);
+            if constexpr (is_same_v<typename G::element, uint64_t>) tie(trace->p, trace->q, trace->r, trace->h, trace->g) = tie(grp.p, grp.q, grp.r, grp.h, grp.g);
+            options.trace = trace.get();
+        }
+        run_stats stats = config.rounds ? run_rounds(pool, *replicas[0], c.l, options)
+                        : pool.size() > 1 ? run_parallel(pool, replicas, c.l, options) : run_serial(*replicas[0], c.l, options);
+        int64_t const run_ns = nanoseconds_since(t1);
+        if (trace)
+        {
+            lock_guard lock(trace_lock);
+            append_trace(config.trace_file, *trace);
+        }
+
+        auto t2 = chrono::steady_clock::now();
+        replicas.clear();
+        int64_t const teardown_ns = nanoseconds_since(t2);
+
+        // Completion of all instances started at once is that of the slowest
+        vector<uint64_t> completion = stats.completion_ns;
+        sort(completion.begin(), completion.end());
+        uint64_t completion_sum = 0;
+        for (uint64_t ns : completion) completion_sum += ns;
+
+        // A single pass writes one row per length it stands in for, all sharing its timings. Memory is
+        // that of the whole flood and the learned topology that of its own length, the row that has them.
+        ostringstream lines;
+        for (int l = c.shortest; l <= c.l; ++l)
+        {
+            bool const own = stats.by_length.empty();
+            const cycle_set &cycles = own ? stats.cycles : stats.at_length(l).cycles;
+            const array<int, 4> &by_type = own ? stats.by_type : stats.at_length(l).by_type;
+
+            result_row row = cell_row(grp, job, c, seed, build_ns);
+            row.l = l;
+            row.n_cyc = (int64_t) cycles.raw();
+            row.n_cyc_unique = (int64_t) cycles.unique();
+            bool const whole_flood = l == c.l;
+            row.known_edges = whole_flood ? (int64_t) stats.known_edges : not_measured;
+            row.known_node_bytes = whole_flood ? (double) stats.known_bytes / job.n : not_measured_f;
+            row.c_edge = own ? stats.cycle_edges : stats.at_length(l).cycle_edges;
+            row.n_msg = own ? stats.messages : stats.at_length(l).messages;
+            row.rerun_msg = row.n_msg;
+            row.n_for = by_type.at(f);
+            row.n_echo = by_type.at(b);
+            row.n_pub = by_type.at(p);
+            row.n_brd = by_type.at(broadcast);
+            row.t = run_ns / 1000000;
+            row.mem = whole_flood ? (int64_t) stats.peak_bytes : not_measured;
+            row.rounds = stats.rounds;
+            row.wire_msg = (int64_t) stats.transport.messages;
+            row.wire_bytes = (int64_t) stats.transport.wire_bytes;
+            row.encode_ns = stats.transport.encode_ns;
+            row.decode_ns = stats.transport.decode_ns;
+            row.transfer_ns = stats.transport.transfer_ns;
+            if (!completion.empty())
+            {
+                row.sim_ns = (int64_t) completion.back();
+                row.sim_mean_ns = (int64_t) (completion_sum / completion.size());
+                row.sim_p99_ns = (int64_t) completion[(completion.size() - 1) * 99 / 100];
+            }
+            // Cleanup is summed over workers, so for a parallel run the wall-clock share is an estimate
+            row.cleanup_ns = stats.cleanup_ns + teardown_ns;
+            row.msg_ns = max<int64_t>(0, run_ns - stats.cleanup_ns / (int64_t) (config.rounds ? 1 : copies));
+            results.write(row);
+            lines << describe<G>(config, row, cycles.collisions()) << (l < c.l ? "\n" : "");
+        }
+
+        lock_guard lock(print);
+        cout << lines.str() << endl;
+    }
+
+    // Runs one cell on a changing graph: a full search, then a row per batch of updates with the
+    // totals on the updated graph and the share of a full recompute the batch's reruns cost
+    void run_dynamic_cell(const sweep_config& config, const group& G, thread_pool& pool, result_writer& results, const cell& c,
+                          const vector<vector<edge_update>>& file_updates)
+    {
+        graph_job &job = *c.job;
+        uint64_t const seed = cell_seed(config.seed, c);
+        auto t0 = chrono::steady_clock::now();
+        dynamic_search search(*job.topology, G, seed, c.l, pool.size());
+        int64_t const build_ns = nanoseconds_since(t0);
+
+        // Generated updates depend on the graph alone, so every length of a graph sees the same stream
+        vector<vector<edge_update>> const generated = config.updates_file.empty()
+            ? random_updates(*job.topology, config.churn_batches, config.churn_edges,
+                             derive_seed(config.seed, { 2, (uint64_t) job.iteration, (uint64_t) job.n, (uint64_t) job.d }))
+            : vector<vector<edge_update>>{};
+        const auto &batches = config.updates_file.empty() ? generated : file_updates;
+
+        ostringstream lines;
+        for (size_t k = 0; k <= batches.size(); ++k)
+        {
+            auto t1 = chrono::steady_clock::now();
+            batch_stats const batch = k == 0 ? search.run_all(pool) : search.apply(batches[k - 1], pool);
+            int64_t const run_ns = nanoseconds_since(t1);
+
+            result_row row = cell_row(G, job, c, seed, build_ns);
+            row.m = (int64_t) search.current().edges();
+            row.d_avg = average_degree(search.current());
+            row.n_cyc = (int64_t) search.raw_cycles();
+            row.n_cyc_unique = (int64_t) search.unique_cycles();
+            row.known_edges = (int64_t) search.known_edges();
+            row.known_node_bytes = (double) search.known_bytes() / job.n;
+            row.c_edge = search.cycle_edges();
+            row.n_msg = search.messages();
+            row.n_for = search.by_type().at(f);
+            row.n_echo = search.by_type().at(b);
+            row.n_pub = search.by_type().at(p);
+            row.n_brd = search.by_type().at(broadcast);
+            row.t = run_ns / 1000000;
+            row.mem = (int64_t) batch.peak_bytes;
+            row.cleanup_ns = batch.cleanup_ns;
+            row.msg_ns = max<int64_t>(0, run_ns - batch.cleanup_ns / (int64_t) pool.size());
+            row.batch = (int64_t) k;
+            row.updates = batch.updates;
+            row.reruns = batch.reruns;
+            row.rerun_msg = batch.messages;
+            results.write(row);
+            lines << describe<group>(config, row, 0) << (k < batches.size() ? "\n" : "");
+        }
+
+        lock_guard lock(print);
+        cout << lines.str() << endl;
+    }
+}
+
+sweep_config sweep_config::parse(int argc, char *argv[])
+{
+    static const char *const positional[] = { "seed", "threads", "engine", "graph" };
+    sweep_config config;
+    int next = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        string const arg = argv[i];
+        size_t const eq = arg.find('=');
+        if (eq != string::npos) config.set(arg.substr(0, eq), arg.substr(eq + 1));
+        else if (next < 4) config.set(positional[next++], arg);
+        else throw invalid_argument("unexpected argument " + arg);
+    }
+    if (config.dynamic() && (config.rounds || config.events || config.single_pass || config.transport != transport_kind::in_process
+                             || config.backend != group_kind::montgomery64))
+        throw invalid_argument("graph updates need the fifo engine, the in-process transport, the default group and one search per length");
+    if (!config.trace_file.empty() && (config.rounds || config.events || config.dynamic()))
+        throw invalid_argument("traces record the fifo engine on fixed graphs only");
+    return config;
+}
+
+void sweep_config::set(const string& key, const string& value)
+{
+    // Whole values only; stoll and stoull name neither the key nor the value when they throw
+    auto checked = [&](auto parse) {
+        size_t used = 0;
+        try
+        {
+            auto const v = parse(value, &used);
+            if (used == value.size()) return v;
+        }
+        catch (const logic_error&) {}
+        throw invalid_argument("bad value for " + key + ": " + value);
+    };
+    auto number = [&] { return checked([](const string& s, size_t *used) { return stoll(s, used); }); };
+    if (key == "config")
+    {
+        ifstream file(value);
+        if (!file) throw invalid_argument("cannot open config file " + value);
+        string text;
+        while (getline(file, text))
+        {
+            text = trim(text.substr(0, text.find('#')));
+            if (text.empty()) continue;
+            size_t const eq = text.find('=');
+            if (eq == string::npos) throw invalid_argument("config line without '=': " + text);
+            set(trim(text.substr(0, eq)), trim(text.substr(eq + 1)));
+        }
+    }
+    else if (key == "seed")
+    {
+        // stoull would wrap a negative seed around
+        seed = checked([](const string& s, size_t *used) {
+            if (s.find('-') != string::npos) throw invalid_argument(s);
+            return stoull(s, used);
+        });
+        has_seed = true;
+    }
+    else if (key == "threads") threads = (unsigned) max(1LL, number());
+    else if (key == "engine")
+    {
+        if (value != "fifo" && value != "rounds" && value != "events") throw invalid_argument("engine must be fifo, rounds or events, not " + value);
+        rounds = value == "rounds";
+        events = value == "events";
+    }
+    else if (key == "graph") graph_file = value;
+    else if (key == "trace") trace_file = value;
+    else if (key == "group_cache") group_cache = value;
+    else if (key == "format") format = parse_result_format(value);
+    else if (key == "transport") transport = parse_transport_kind(value);
+    else if (key == "group") backend = parse_group_kind(value);
+    else if (key == "latency") latency = delay_dist::parse(value);
+    else if (key == "jitter") jitter = delay_dist::parse(value);
+    else if (key == "check_cycles") check_cycles = number() != 0;
+    else if (key == "single_pass") single_pass = number() != 0;
+    else if (key == "perf") perf = number() != 0;
+    else if (key == "updates") updates_file = value;
+    else if (key == "churn_batches") churn_batches = (int) max(0LL, number());
+    else if (key == "churn_edges") churn_edges = (int) max(0LL, number());
+    else if (key == "l_lower") l_lower = (int) number();
+    else if (key == "l_upper") l_upper = (int) number();
+    else if (key == "n_lower") n_lower = (int) number();
+    else if (key == "n_upper") n_upper = (int) number();
+    else if (key == "d_lower") d_lower = (int) number();
+    else if (key == "d_upper") d_upper = (int) number();
+    else if (key == "iterations") iterations = (int) number();
+    else throw invalid_argument("unknown setting " + key);
+}
+
+template<group_backend G>
+void run_sweep(const sweep_config& config, const G& grp, thread_pool& pool, result_writer& results)
+{
+    // Determines the number of iterations, the size of the graph and its density; a graph file has
+    // fixed size and density, so only the iterations remain
+    vector<unique_ptr<graph_job>> jobs;
+    for(int iteration = 0; iteration < config.iterations; ++iteration)
+    {
+        if (!config.graph_file.empty())
+        {
+            jobs.push_back(make_unique<graph_job>());
+            jobs.back()->iteration = iteration;
+            jobs.back()->n = jobs.back()->d = 0;
+            jobs.back()->seed = 0;
+            continue;
+        }
+        for(int i = config.n_lower; i <= config.n_upper; ++i)
+        {
+            for(int j = config.d_lower; j <= config.d_upper; ++j)
+            {
+                jobs.push_back(make_unique<graph_job>());
+                graph_job &job = *jobs.back();
+                job.iteration = iteration;
+                job.n = i;
+                job.d = j;
+                job.seed = derive_seed(config.seed, { 0, (uint64_t) iteration, (uint64_t) i, (uint64_t) j });
+            }
+        }
+    }
+
+    // Determines the upper cycle length (search depth)
+    vector<cell> cells;
+    for (auto &job : jobs)
+    {
+        if (config.single_pass) cells.push_back({ job.get(), config.l_upper, config.l_lower });
+        else for(int k = config.l_lower; k <= config.l_upper; ++k) cells.push_back({ job.get(), k, k });
+        job->remaining = config.single_pass ? 1 : config.l_upper - config.l_lower + 1;
+    }
+
+    // Cells add their runs to the trace as they finish
+    if (!config.trace_file.empty()) create_trace(config.trace_file);
+
+    // An update file is read once and applied to every graph
+    vector<vector<edge_update>> const file_updates = config.updates_file.empty() ? vector<vector<edge_update>>{} : load_updates(config.updates_file);
+
+    // A graph file is loaded once and shared by all iterations
+    shared_ptr<graph> file_graph;
+    int64_t file_gen_ns = 0;
+    if (!config.graph_file.empty())
+    {
+        auto t0 = chrono::steady_clock::now();
+        file_graph = make_shared<graph>(load_graph(config.graph_file));
+        file_gen_ns = nanoseconds_since(t0);
+    }
+
+    auto prepare = [&](graph_job& job, thread_pool *generator) {
+        call_once(job.built, [&] {
+            auto t0 = chrono::steady_clock::now();
+            // Generate a random graph with specified parameters (n=i, m=j, m0=j)
+            if (file_graph)
+            {
+                job.topology = make_unique<graph>(*file_graph);
+                job.n = job.topology->size();
+                job.m = (int) job.topology->edges();
+                job.d_avg = average_degree(*job.topology);
+                job.gen_ns = file_gen_ns;
+                return;
+            }
+            auto [m, d_avg, topology] = generate_scale_free_graph(job.d, job.d, job.n, job.seed, generator);
+            job.topology = make_unique<graph>(std::move(topology));
+            job.m = m;
+            job.d_avg = d_avg;
+            job.gen_ns = nanoseconds_since(t0);
+        });
+    };
+    auto run = [&](thread_pool& on, const cell& c) {
+        if constexpr (is_same_v<G, group>)
+            if (config.dynamic()) return run_dynamic_cell(config, grp, on, results, c, file_updates);
+        run_cell(config, grp, on, results, c);
+    };
+    auto finish = [](graph_job& job) {
+        if (--job.remaining == 0) job.topology.reset();
+    };
+
+    if (cells.size() >= pool.size() && pool.size() > 1)
+    {
+        pool.parallel_for(cells.size(), [&](size_t i, unsigned) {
+            thread_pool own(1);     // just the calling thread, so the cell runs serially
+            prepare(*cells[i].job, nullptr);
+            run(own, cells[i]);
+            finish(*cells[i].job);
+        });
+        return;
+    }
+    for (const cell &c : cells)
+    {
+        prepare(*c.job, &pool);
+        run(pool, c);
+        finish(*c.job);
+    }
+}
+
+template void run_sweep(const sweep_config&, const small_group&, thread_pool&, result_writer&);
+template void run_sweep(const sweep_config&, const group&, thread_pool&, result_writer&);
+template void run_sweep(const sweep_config&, const modp2048&, thread_pool&, result_writer&);
+template void run_sweep(const sweep_config&, const modp3072&, thread_pool&, result_writer&);
@@ -0,0 +1,66 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <cstdint>
+#include <string>
+#include "group.h"
+#include "latency.h"
+#include "results.h"
+#include "thread_pool.h"
+#include "transport.h"
+
+using namespace std;
+
+// Parameters of an experiment sweep. Every (iteration, n, d) combination is one generated graph,
+// searched for every cycle length l; a graph file replaces the generated graphs.
+struct sweep_config
+{
+    int l_lower    =   2;   // cycle length min 2
+    int l_upper    =   4;   // cycle length max 4
+    int n_lower    =   50;  // size min
+    int n_upper    =   50;  // size max
+    int d_lower    =   3;   // m min (lower m is lower average degree)
+    int d_upper    =   9;   // m max (higher m is higher average degree)
+    int iterations =   1;   // amount of times to repeat experiment
+    uint64_t seed  =   0;   // master seed, drawn at random unless has_seed
+    bool has_seed  =   false;
+    unsigned threads = 1;
+    bool rounds    =   false;   // round engine instead of fifo
+    bool events    =   false;   // discrete-event engine: fifo instances delivered by simulated latency
+    delay_dist latency{ delay_dist::shape::constant, 1000, 0 };     // per-edge base latency, events only
+    delay_dist jitter;                                              // added to every message, events only
+    bool check_cycles = false;  // keep found cycles to detect fingerprint collisions
+    bool single_pass = false;   // one flood of l_upper per graph, reported for every l
+    bool perf      =   false;   // read hardware counters into the profile
+    string graph_file;
+    string group_cache = "out/groups.txt";  // validated group parameters by size; empty to search every run
+    string trace_file;          // records every run's messages for replaying, fifo engine only
+    string updates_file;        // batches of edge updates applied to every graph after its first search
+    int churn_batches =  0;     // without a file, batches of random updates per graph
+    int churn_edges   = 10;     // updates per random batch
+    result_format format = result_format::csv;
+    transport_kind transport = transport_kind::in_process;     // how messages reach their targets
+    group_kind backend = group_kind::montgomery64;              // the group the nodes compute in
+
+    // Reads "key=value" arguments, where config=<file> reads one such pair per line of the file and
+    // '#' starts a comment. Bare arguments keep their old positional meaning: seed, threads, engine
+    // and graph file. Throws invalid_argument on an unknown key or a bad value.
+    static sweep_config parse(int argc, char *argv[]);
+
+    void set(const string& key, const string& value);
+
+    // Whether the graphs change after their first search
+    [[nodiscard]] bool dynamic() const { return !updates_file.empty() || churn_batches > 0; }
+};
+
+// Runs every cell of the sweep, writes its rows to results and prints a summary line per row. On a
+// dynamic sweep a cell searches its graph once and then keeps the search current through every batch
+// of updates, rerunning only the instances a batch affects, with a row per batch. Cells
+// run in parallel on the pool, one simulation each, when there are at least as many as workers;
+// otherwise one after another, each spread over the whole pool. Graph and cell seeds are derived from the master seed and the cell's
+// coordinates, so a row does not depend on the thread count or on which other cells ran. Graph
+// updates are only supported in the default group.
+template<group_backend G>
+void run_sweep(const sweep_config& config, const G& grp, thread_pool& pool, result_writer& results);
+
+#endif
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <utility>
+#include "thread_pool.h"
+
+using namespace std;
+
+thread_pool::thread_pool(unsigned threads)
+{
+    threads = max(threads, 1U);
+    for (unsigned w = 0; w < threads; ++w) queues.push_back(make_unique<task_queue>());
+    for (unsigned w = 1; w < threads; ++w) workers.emplace_back(&thread_pool::worker_loop, this, w);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        lock_guard lock(m);
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto &t : workers) t.join();
+}
+
+void thread_pool::parallel_for(size_t n, const task_fn& fn)
+{
+    if (n == 0) return;
+    {
+        lock_guard lock(m);
+        job = &fn;
+        remaining = n;
+        failed = false;
+        failure = nullptr;
+        // Contiguous blocks keep neighbouring tasks on one worker until stealing kicks in
+        size_t const workers_n = queues.size();
+        for (size_t w = 0; w < workers_n; ++w)
+        {
+            lock_guard queue_lock(queues[w]->m);
+            for (size_t i = n * w / workers_n; i < n * (w + 1) / workers_n; ++i) queues[w]->tasks.push_back(i);
+        }
+        ++generation;
+    }
+    wake.notify_all();
+    work(0);
+
+    unique_lock lock(m);
+    finished.wait(lock, [this] { return remaining == 0; });
+    job = nullptr;
+    if (failure) rethrow_exception(exchange(failure, nullptr));
+}
+
+void thread_pool::worker_loop(unsigned worker)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            unique_lock lock(m);
+            wake.wait(lock, [&] { return stop || generation != seen; });
+            if (stop) return;
+            seen = generation;
+        }
+        work(worker);
+    }
+}
+
+void thread_pool::work(unsigned worker)
+{
+    size_t task;
+    while (take(worker, task))
+    {
+        // The other workers may still be using job, so a failed task is only recorded and the
+        // queues drained before parallel_for returns
+        if (!failed)
+        {
+            try
+            {
+                (*job)(task, worker);
+            }
+            catch (...)
+            {
+                lock_guard lock(m);
+                if (!failure) failure = current_exception();
+                failed = true;
+            }
+        }
+        if (--remaining == 0)
+        {
+            lock_guard lock(m);
+            finished.notify_all();
+        }
+    }
+}
+
+bool thread_pool::take(unsigned worker, size_t& task)
+{
+    {
+        task_queue &own = *queues[worker];
+        lock_guard lock(own.m);
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues.size(); ++k)
+    {
+        task_queue &victim = *queues[(worker + k) % queues.size()];
+        lock_guard lock(victim.m);
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
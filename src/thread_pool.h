@@ -0,0 +1,60 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Fixed set of workers, each with its own task deque: a worker pops its own tasks from the back
+// and, once it runs dry, steals from the front of the others. The calling thread is worker 0.
+class thread_pool
+{
+    public:
+        using task_fn = function<void(size_t task, unsigned worker)>;
+
+        explicit thread_pool(unsigned threads);
+        ~thread_pool();
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        [[nodiscard]] unsigned size() const { return (unsigned) queues.size(); }
+
+        // Runs fn(i, worker) for every i in [0, n) and returns once all calls have finished. If a call
+        // throws, the tasks not yet started are skipped and the first exception is rethrown here.
+        void parallel_for(size_t n, const task_fn& fn);
+
+    private:
+        struct task_queue
+        {
+            mutex m;
+            deque<size_t> tasks;
+        };
+
+        vector<unique_ptr<task_queue>> queues;
+        vector<thread> workers;
+
+        mutex m;
+        condition_variable wake;
+        condition_variable finished;
+        const task_fn *job = nullptr;
+        uint64_t generation = 0;
+        atomic<size_t> remaining{0};
+        atomic<bool> failed{false};
+        exception_ptr failure;              // guarded by m
+        bool stop = false;
+
+        void worker_loop(unsigned worker);
+        void work(unsigned worker);
+        bool take(unsigned worker, size_t& task);
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include <bit>
+#include "timing_wheel.h"
+
+using namespace std;
+
+void timing_wheel::clear(uint64_t start)
+{
+    time = start;
+    if (count == 0) return;     // popping leaves every slot empty
+    count = 0;
+    for (auto &level : wheel) level.fill({});
+    for (auto &bits : occupied) bits.fill(0);
+}
+
+void timing_wheel::push(uint32_t id, uint64_t due)
+{
+    if (id >= due_at.size())
+    {
+        due_at.resize(max<size_t>((size_t) id + 1, 2 * due_at.size()));
+        next.resize(due_at.size());
+    }
+    due_at[id] = max(due, time);
+    link(id);
+    ++count;
+}
+
+void timing_wheel::link(uint32_t id)
+{
+    uint64_t const due = due_at[id];
+    uint64_t const differs = due ^ time;
+    int const level = differs < slots ? 0 : (bit_width(differs) - 1) / slot_bits;
+    auto const index = (int) ((due >> (level * slot_bits)) & (slots - 1));
+
+    slot_list &slot = wheel[level][index];
+    next[id] = none;
+    if (slot.tail == none) slot.head = id;
+    else next[slot.tail] = id;
+    slot.tail = id;
+    occupied[level][index / 64] |= 1ULL << (index % 64);
+}
+
+int timing_wheel::find(int level, int from) const
+{
+    for (int word = from / 64; word < slots / 64; ++word)
+    {
+        uint64_t bits = occupied[level][word];
+        if (word == from / 64) bits &= ~0ULL << (from % 64);
+        if (bits) return word * 64 + countr_zero(bits);
+    }
+    return slots;
+}
+
+bool timing_wheel::pop(uint32_t& id)
+{
+    if (count == 0) return false;
+    while (true)
+    {
+        int const index = find(0, (int) (time & (slots - 1)));
+        if (index < slots)
+        {
+            time = (time & ~(uint64_t) (slots - 1)) | (uint64_t) index;
+            slot_list &slot = wheel[0][index];
+            id = slot.head;
+            slot.head = next[id];
+            if (slot.head == none)
+            {
+                slot.tail = none;
+                occupied[0][index / 64] &= ~(1ULL << (index % 64));
+            }
+            --count;
+            return true;
+        }
+
+        // The level 0 window is used up: move to the next occupied slot of the lowest level that has
+        // one and spread its items over the levels below
+        for (int level = 1; level < levels; ++level)
+        {
+            int const shift = level * slot_bits;
+            auto const position = (int) ((time >> shift) & (slots - 1));
+            int const found = position + 1 < slots ? find(level, position + 1) : slots;
+            if (found == slots) continue;
+
+            uint64_t const window = shift + slot_bits < 64 ? time >> (shift + slot_bits) << (shift + slot_bits) : 0;
+            time = window | (uint64_t) found << shift;
+            slot_list &slot = wheel[level][found];
+            uint32_t item = slot.head;
+            slot = {};
+            occupied[level][found / 64] &= ~(1ULL << (found % 64));
+            while (item != none)
+            {
+                uint32_t const following = next[item];
+                link(item);
+                item = following;
+            }
+            break;
+        }
+    }
+}
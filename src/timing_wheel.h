@@ -0,0 +1,54 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Hierarchical timing wheel over 64-bit times: eight levels of 256 slots, level k holding the items
+// due in a later slot of the current level k + 1 window, i.e. whose time first differs from now in
+// byte k. Items are small integer ids whose payload the caller keeps; each slot is an intrusive FIFO
+// list threaded through per-id arrays, so pushing and popping never allocate once the arrays have
+// grown. Occupancy bitmaps let pop() skip empty slots, and a level's slot is spread over the levels
+// below only when time reaches it. Items due at the same time come out in the order pushed.
+class timing_wheel
+{
+    public:
+        // Empties the wheel and sets the time
+        void clear(uint64_t start = 0);
+
+        // Schedules id, which must not be scheduled already, at due; a time already past counts as now
+        void push(uint32_t id, uint64_t due);
+
+        // Takes the earliest item, advancing the time to its due time; false if the wheel is empty
+        bool pop(uint32_t& id);
+
+        [[nodiscard]] uint64_t now() const { return time; }
+        [[nodiscard]] bool empty() const { return count == 0; }
+        [[nodiscard]] size_t size() const { return count; }
+
+    private:
+        static constexpr int levels = 8, slot_bits = 8, slots = 1 << slot_bits;
+        static constexpr uint32_t none = UINT32_MAX;
+
+        struct slot_list
+        {
+            uint32_t head = none, tail = none;
+        };
+
+        uint64_t time = 0;
+        size_t count = 0;
+        array<array<slot_list, slots>, levels> wheel{};
+        array<array<uint64_t, slots / 64>, levels> occupied{};
+        vector<uint64_t> due_at;    // by id
+        vector<uint32_t> next;      // by id, the next item of the same slot
+
+        void link(uint32_t id);
+
+        // First occupied slot of the level at or after from, or slots if there is none
+        [[nodiscard]] int find(int level, int from) const;
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "random.h"
+#include "trace.h"
+
+using namespace std;
+
+namespace
+{
+    constexpr char magic[8] = { 'C', 'Y', 'C', 'T', 'R', 'A', 'C', 'E' };
+    constexpr uint64_t version = 1;
+
+    void put_string(const string& s, vector<uint8_t>& out)
+    {
+        put_varint(s.size(), out);
+        out.insert(out.end(), s.begin(), s.end());
+    }
+
+    // Bytes taken from the front of in; throws if there are fewer
+    span<const uint8_t> take(span<const uint8_t>& in, uint64_t n)
+    {
+        if (n > in.size()) throw runtime_error("trace: truncated file");
+        span<const uint8_t> const taken = in.first(n);
+        in = in.subspan(n);
+        return taken;
+    }
+
+    string get_string(span<const uint8_t>& in)
+    {
+        span<const uint8_t> const s = take(in, get_varint(in));
+        return { s.begin(), s.end() };
+    }
+
+    int get_int(span<const uint8_t>& in)
+    {
+        uint64_t const value = get_varint(in);
+        if (value > INT32_MAX) throw runtime_error("trace: field out of range");
+        return (int) value;
+    }
+}
+
+trace_run::trace_run(string backend, graph topology, uint64_t seed, int l, int shortest)
+    : backend(std::move(backend)), rng(engineName()), master_seed(getMasterSeed()), seed(seed), l(l), shortest(shortest),
+      topology(std::move(topology)), instances(this->topology.size())
+{
+}
+
+size_t trace_run::messages() const
+{
+    size_t total = 0;
+    for (const auto &instance : instances) total += instance.messages;
+    return total;
+}
+
+size_t trace_run::bytes() const
+{
+    size_t total = 0;
+    for (const auto &instance : instances) total += instance.bytes.size();
+    return total;
+}
+
+void create_trace(const string& path)
+{
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file) throw runtime_error("create_trace: cannot create " + path);
+    vector<uint8_t> header(begin(magic), end(magic));
+    put_varint(version, header);
+    file.write((const char *) header.data(), (streamsize) header.size());
+    if (!file) throw runtime_error("create_trace: cannot write " + path);
+}
+
+void append_trace(const string& path, const trace_run& run)
+{
+    vector<uint8_t> out;
+    put_string(run.backend, out);
+    for (uint64_t parameter : { run.p, run.q, run.r, run.h, run.g }) put_varint(parameter, out);
+    put_string(run.rng, out);
+    put_varint(run.master_seed, out);
+    put_varint(run.seed, out);
+    put_varint((uint64_t) run.l, out);
+    put_varint((uint64_t) run.shortest, out);
+
+    int const n = run.topology.size();
+    put_varint((uint64_t) n, out);
+    for (int v = 0; v < n; ++v)
+    {
+        put_varint(run.topology.degree(v), out);
+        for (int target : run.topology.neighbours(v)) put_varint((uint32_t) target, out);
+    }
+    for (const auto &instance : run.instances)
+    {
+        put_varint(instance.initial, out);
+        put_varint(instance.messages, out);
+        put_varint(instance.bytes.size(), out);
+        out.insert(out.end(), instance.bytes.begin(), instance.bytes.end());
+    }
+
+    ofstream file(path, ios::binary | ios::app);
+    if (!file) throw runtime_error("append_trace: cannot open " + path);
+    file.write((const char *) out.data(), (streamsize) out.size());
+    if (!file) throw runtime_error("append_trace: cannot write " + path);
+}
+
+vector<trace_run> load_trace(const string& path)
+{
+    ifstream file(path, ios::binary);
+    if (!file) throw runtime_error("load_trace: cannot open " + path);
+    vector<uint8_t> const contents{ istreambuf_iterator<char>(file), istreambuf_iterator<char>() };
+    span<const uint8_t> in = contents;
+    if (in.size() < sizeof(magic) || memcmp(in.data(), magic, sizeof(magic)) != 0) throw runtime_error("load_trace: " + path + " is not a trace file");
+    in = in.subspan(sizeof(magic));
+    if (get_varint(in) != version) throw runtime_error("load_trace: " + path + " is a trace file of another version");
+
+    vector<trace_run> runs;
+    while (!in.empty())
+    {
+        trace_run &run = runs.emplace_back();
+        run.backend = get_string(in);
+        for (uint64_t *parameter : { &run.p, &run.q, &run.r, &run.h, &run.g }) *parameter = get_varint(in);
+        run.rng = get_string(in);
+        run.master_seed = get_varint(in);
+        run.seed = get_varint(in);
+        run.l = get_int(in);
+        run.shortest = get_int(in);
+
+        int const n = get_int(in);
+        vector<size_t> offsets = { 0 };
+        vector<int> targets;
+        for (int v = 0; v < n; ++v)
+        {
+            uint64_t const degree = get_varint(in);
+            if (degree > in.size()) throw runtime_error("trace: truncated file");
+            for (uint64_t k = 0; k < degree; ++k)
+            {
+                int const target = get_int(in);
+                if (target >= n) throw runtime_error("trace: edge to a node outside the graph");
+                targets.push_back(target);
+            }
+            offsets.push_back(targets.size());
+        }
+        run.topology = graph(std::move(offsets), std::move(targets));
+
+        run.instances.resize(n);
+        for (auto &instance : run.instances)
+        {
+            instance.initial = (uint32_t) get_varint(in);
+            instance.messages = (uint32_t) get_varint(in);
+            span<const uint8_t> const bytes = take(in, get_varint(in));
+            instance.bytes.assign(bytes.begin(), bytes.end());
+        }
+    }
+    return runs;
+}
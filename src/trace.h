@@ -0,0 +1,63 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "graph.h"
+#include "message.h"
+#include "path.h"
+#include "wire.h"
+
+using namespace std;
+
+// The messages of one instance in the order the fifo engine delivered them. Each is the number of
+// replies it sent followed by its wire encoding, so the queue's whole history can be rebuilt: the
+// replies of a message are the next ones not yet accounted for.
+struct trace_instance
+{
+    uint32_t initial = 0;       // messages initiate() sent
+    uint32_t messages = 0;
+    vector<uint8_t> bytes;
+};
+
+// A fifo run as a trace: the graph, group, generator and seeds it ran with and every instance's
+// message stream, enough to redo it exactly. The one-word groups are stored by their parameters,
+// the wide ones by name.
+struct trace_run
+{
+    string backend;                     // group_name of the group
+    uint64_t p = 0, q = 0, r = 0, h = 0, g = 0;
+    string rng;                         // engineName() of the generator the nodes drew from
+    uint64_t master_seed = 0;           // every thread's stream derives from it
+    uint64_t seed = 0;                  // simulation seed
+    int l = 0, shortest = 0;
+    graph topology;
+    vector<trace_instance> instances;   // by initiator
+
+    trace_run() = default;
+    // An empty trace with a slot for every initiator, ready for recording
+    trace_run(string backend, graph topology, uint64_t seed, int l, int shortest);
+
+    [[nodiscard]] size_t messages() const;
+    [[nodiscard]] size_t bytes() const;
+};
+
+// Appends a delivered message and the number of replies it sent to the instance's stream
+template<group_backend G>
+void record(trace_instance& to, const basic_message<G>& msg, size_t replies, const path_store& paths)
+{
+    put_varint(replies, to.bytes);
+    encode(msg, paths, to.bytes);
+    ++to.messages;
+}
+
+// Trace files: an 8-byte magic and a version, then runs, each its fields as varints (names as their
+// length and bytes), the graph as rows of degree and targets, and the instances as their counts, byte
+// length and bytes. create_trace starts a file, replacing any there; append_trace adds a run.
+// load_trace reads every run and throws runtime_error on a malformed file.
+void create_trace(const string& path);
+void append_trace(const string& path, const trace_run& run);
+vector<trace_run> load_trace(const string& path);
+
+#endif
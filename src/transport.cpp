@@ -0,0 +1,370 @@
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "clock.h"
+#include "transport.h"
+#include "wire.h"
+
+using namespace std;
+
+namespace
+{
+    [[noreturn]] void fail(const string& what)
+    {
+        throw runtime_error(what + ": " + strerror(errno));
+    }
+
+    // Spins briefly, then yields, then sleeps, so an idle relay does not hold a core
+    class backoff
+    {
+        public:
+            void idle()
+            {
+                if (++polls < 64) return;
+                if (polls < 4096) this_thread::yield();
+                else usleep(50);
+            }
+            void progress() { polls = 0; }
+
+        private:
+            int polls = 0;
+    };
+
+    template<group_backend G>
+    class in_process_transport final : public basic_transport<G>
+    {
+        public:
+            void carry(vector<basic_message<G>>& out, size_t from, path_store&) override
+            {
+                ++this->counters.batches;
+                this->counters.messages += out.size() - from;
+            }
+
+            [[nodiscard]] transport_kind kind() const override { return transport_kind::in_process; }
+    };
+
+    // A byte channel to a relay process that echoes back whatever it is sent
+    class relay
+    {
+        public:
+            virtual ~relay() = default;
+
+            // Sends all of sent and fills received with as many bytes from the relay
+            virtual void exchange(const vector<uint8_t>& sent, vector<uint8_t>& received) = 0;
+
+            [[nodiscard]] virtual transport_kind kind() const = 0;
+
+        protected:
+            static constexpr size_t relay_buffer = 1 << 16;
+            pid_t process = -1;
+
+            // Forks the relay process, which runs body and exits; the body must not allocate, since
+            // another thread may have held the allocator's lock at the fork
+            template<typename F>
+            void start_relay(F body)
+            {
+                process = fork();
+                if (process < 0) fail("transport: fork");
+                if (process == 0)
+                {
+                    body();
+                    _exit(0);
+                }
+            }
+
+            void wait_relay()
+            {
+                if (process > 0) waitpid(process, nullptr, 0);
+                process = -1;
+            }
+    };
+
+    // Encodes every batch, echoes it through a relay and decodes the echo
+    template<group_backend G>
+    class relayed_transport final : public basic_transport<G>
+    {
+        public:
+            explicit relayed_transport(unique_ptr<relay> channel) : channel(std::move(channel)) {}
+
+            void carry(vector<basic_message<G>>& out, size_t from, path_store& paths) override
+            {
+                if (from == out.size()) return;
+                auto t0 = chrono::steady_clock::now();
+                sent.clear();
+                for (size_t i = from; i < out.size(); ++i) encode(out[i], paths, sent);
+                auto t1 = chrono::steady_clock::now();
+                received.resize(sent.size());
+                channel->exchange(sent, received);
+                auto t2 = chrono::steady_clock::now();
+                span<const uint8_t> in(received);
+                for (size_t i = from; i < out.size(); ++i) out[i] = decode<G>(in, paths);
+                if (!in.empty()) throw runtime_error("transport: relay returned more than was sent");
+
+                transport_stats &counters = this->counters;
+                ++counters.batches;
+                counters.messages += out.size() - from;
+                counters.wire_bytes += sent.size();
+                counters.encode_ns += chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count();
+                counters.transfer_ns += chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
+                counters.decode_ns += nanoseconds_since(t2);
+            }
+
+            [[nodiscard]] transport_kind kind() const override { return channel->kind(); }
+
+        private:
+            unique_ptr<relay> channel;
+            vector<uint8_t> sent, received;
+    };
+
+    // Two single-producer single-consumer byte rings in an anonymous shared mapping, one towards
+    // the relay and one back. Head and tail only grow, each is written by one side alone and they
+    // sit on separate cache lines; the byte at index i is data[i % capacity].
+    struct shm_ring
+    {
+        static constexpr size_t capacity = 1 << 20;
+
+        alignas(64) atomic<uint64_t> head{0};   // bytes consumed
+        alignas(64) atomic<uint64_t> tail{0};   // bytes produced
+        alignas(64) uint8_t data[capacity];
+
+        size_t write(const uint8_t *from, size_t n)
+        {
+            uint64_t const t = tail.load(memory_order_relaxed);
+            n = min<size_t>(n, capacity - (t - head.load(memory_order_acquire)));
+            size_t const at = t % capacity, first = min(n, capacity - at);
+            memcpy(data + at, from, first);
+            memcpy(data, from + first, n - first);
+            tail.store(t + n, memory_order_release);
+            return n;
+        }
+
+        size_t read(uint8_t *to, size_t n)
+        {
+            uint64_t const h = head.load(memory_order_relaxed);
+            n = min<size_t>(n, tail.load(memory_order_acquire) - h);
+            size_t const at = h % capacity, first = min(n, capacity - at);
+            memcpy(to, data + at, first);
+            memcpy(to + first, data, n - first);
+            head.store(h + n, memory_order_release);
+            return n;
+        }
+    };
+    static_assert(atomic<uint64_t>::is_always_lock_free, "the rings are shared between processes");
+
+    struct shm_region
+    {
+        shm_ring to_relay, from_relay;
+        alignas(64) atomic<bool> stop{false};
+    };
+
+    class shared_memory_relay final : public relay
+    {
+        public:
+            shared_memory_relay()
+            {
+                void *mapping = mmap(nullptr, sizeof(shm_region), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+                if (mapping == MAP_FAILED) fail("transport: mmap");
+                region = new (mapping) shm_region;
+                start_relay([r = region] {
+                    static uint8_t buffer[relay_buffer];
+                    backoff wait;
+                    while (true)
+                    {
+                        size_t const n = r->to_relay.read(buffer, relay_buffer);
+                        if (n == 0)
+                        {
+                            if (r->stop.load(memory_order_acquire)) return;
+                            wait.idle();
+                            continue;
+                        }
+                        wait.progress();
+                        for (size_t done = 0; done < n;)
+                        {
+                            size_t const w = r->from_relay.write(buffer + done, n - done);
+                            done += w;
+                            if (w == 0) wait.idle();
+                        }
+                    }
+                });
+            }
+
+            ~shared_memory_relay() override
+            {
+                region->stop.store(true, memory_order_release);
+                wait_relay();
+                region->~shm_region();
+                munmap(region, sizeof(shm_region));
+            }
+
+            [[nodiscard]] transport_kind kind() const override { return transport_kind::shared_memory; }
+
+            void exchange(const vector<uint8_t>& sent, vector<uint8_t>& received) override
+            {
+                // Both directions at once, so a batch larger than a ring cannot deadlock
+                backoff wait;
+                size_t put = 0, got = 0;
+                while (got < received.size())
+                {
+                    size_t const w = put < sent.size() ? region->to_relay.write(sent.data() + put, sent.size() - put) : 0;
+                    size_t const r = region->from_relay.read(received.data() + got, received.size() - got);
+                    put += w;
+                    got += r;
+                    if (w + r == 0) wait.idle();
+                    else wait.progress();
+                }
+            }
+
+        private:
+            shm_region *region = nullptr;
+    };
+
+    class socket_relay final : public relay
+    {
+        public:
+            explicit socket_relay(bool tcp) : tcp(tcp)
+            {
+                int ends[2];
+                if (tcp) connect_loopback(ends);
+                else if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends) != 0) fail("transport: socketpair");
+                fd = ends[0];
+                int const relay_fd = ends[1];
+                start_relay([relay_fd] {
+                    static uint8_t buffer[relay_buffer];
+                    while (true)
+                    {
+                        ssize_t const n = read(relay_fd, buffer, relay_buffer);
+                        if (n < 0 && errno == EINTR) continue;
+                        if (n <= 0) return;
+                        for (ssize_t done = 0; done < n;)
+                        {
+                            ssize_t const w = write(relay_fd, buffer + done, (size_t) (n - done));
+                            if (w < 0 && errno == EINTR) continue;
+                            if (w <= 0) return;
+                            done += w;
+                        }
+                    }
+                });
+                close(relay_fd);
+            }
+
+            ~socket_relay() override
+            {
+                // Other relays forked later hold copies of fd, so only a shutdown tells the relay to stop
+                shutdown(fd, SHUT_RDWR);
+                close(fd);
+                wait_relay();
+            }
+
+            [[nodiscard]] transport_kind kind() const override { return tcp ? transport_kind::tcp_socket : transport_kind::unix_socket; }
+
+            void exchange(const vector<uint8_t>& sent, vector<uint8_t>& received) override
+            {
+                // Writes and reads interleaved, so a batch larger than the socket buffers cannot deadlock
+                size_t put = 0, got = 0;
+                while (got < received.size())
+                {
+                    pollfd p{ fd, (short) (POLLIN | (put < sent.size() ? POLLOUT : 0)), 0 };
+                    if (poll(&p, 1, -1) < 0)
+                    {
+                        if (errno == EINTR) continue;
+                        fail("transport: poll");
+                    }
+                    if ((p.revents & POLLOUT) && put < sent.size())
+                    {
+                        ssize_t const w = send(fd, sent.data() + put, sent.size() - put, MSG_DONTWAIT | MSG_NOSIGNAL);
+                        if (w > 0) put += (size_t) w;
+                        else if (w < 0 && errno != EAGAIN && errno != EINTR) fail("transport: send");
+                    }
+                    if (p.revents & (POLLIN | POLLHUP | POLLERR))
+                    {
+                        ssize_t const r = recv(fd, received.data() + got, received.size() - got, MSG_DONTWAIT);
+                        if (r > 0) got += (size_t) r;
+                        else if (r == 0) throw runtime_error("transport: relay closed the connection");
+                        else if (errno != EAGAIN && errno != EINTR) fail("transport: recv");
+                    }
+                }
+            }
+
+        private:
+            bool tcp;
+            int fd = -1;
+
+            static void connect_loopback(int ends[2])
+            {
+                int const listener = socket(AF_INET, SOCK_STREAM, 0);
+                if (listener < 0) fail("transport: socket");
+                sockaddr_in address{};
+                address.sin_family = AF_INET;
+                address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                socklen_t length = sizeof(address);
+                if (bind(listener, (sockaddr *) &address, length) != 0 || listen(listener, 1) != 0
+                    || getsockname(listener, (sockaddr *) &address, &length) != 0)
+                    fail("transport: listen on loopback");
+                ends[0] = socket(AF_INET, SOCK_STREAM, 0);
+                if (ends[0] < 0 || connect(ends[0], (sockaddr *) &address, length) != 0) fail("transport: connect to loopback");
+                ends[1] = accept(listener, nullptr, nullptr);
+                if (ends[1] < 0) fail("transport: accept on loopback");
+                close(listener);
+                int const on = 1;
+                setsockopt(ends[0], IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                setsockopt(ends[1], IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            }
+    };
+}
+
+void transport_stats::merge(const transport_stats& other)
+{
+    batches += other.batches;
+    messages += other.messages;
+    wire_bytes += other.wire_bytes;
+    encode_ns += other.encode_ns;
+    decode_ns += other.decode_ns;
+    transfer_ns += other.transfer_ns;
+}
+
+template<group_backend G>
+unique_ptr<basic_transport<G>> make_transport(transport_kind kind)
+{
+    switch (kind)
+    {
+        case transport_kind::shared_memory: return make_unique<relayed_transport<G>>(make_unique<shared_memory_relay>());
+        case transport_kind::unix_socket: return make_unique<relayed_transport<G>>(make_unique<socket_relay>(false));
+        case transport_kind::tcp_socket: return make_unique<relayed_transport<G>>(make_unique<socket_relay>(true));
+        default: return make_unique<in_process_transport<G>>();
+    }
+}
+
+template unique_ptr<basic_transport<small_group>> make_transport(transport_kind);
+template unique_ptr<basic_transport<group>> make_transport(transport_kind);
+template unique_ptr<basic_transport<modp2048>> make_transport(transport_kind);
+template unique_ptr<basic_transport<modp3072>> make_transport(transport_kind);
+
+transport_kind parse_transport_kind(const string& name)
+{
+    for (auto kind : { transport_kind::in_process, transport_kind::shared_memory, transport_kind::unix_socket, transport_kind::tcp_socket })
+        if (name == transport_name(kind)) return kind;
+    throw invalid_argument("transport must be inproc, shm, unix or tcp, not " + name);
+}
+
+const char *transport_name(transport_kind kind)
+{
+    switch (kind)
+    {
+        case transport_kind::shared_memory: return "shm";
+        case transport_kind::unix_socket: return "unix";
+        case transport_kind::tcp_socket: return "tcp";
+        default: return "inproc";
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "message.h"
+#include "path.h"
+
+using namespace std;
+
+enum class transport_kind { in_process, shared_memory, unix_socket, tcp_socket };
+
+// Traffic through one transport
+struct transport_stats
+{
+    uint64_t batches = 0;
+    uint64_t messages = 0;
+    uint64_t wire_bytes = 0;    // encoded bytes sent, each also received back
+    int64_t encode_ns = 0;
+    int64_t decode_ns = 0;
+    int64_t transfer_ns = 0;    // from the first byte sent to the last byte received
+
+    void merge(const transport_stats& other);
+};
+
+// Carries the messages a simulation's handlers send to their targets. The in-process transport
+// hands them over as they are. The others encode each batch into the wire format, send it to a
+// relay process over a real channel, decode what comes back into the simulation's path store and
+// deliver that instead, so a run pays the encoding and the channel for every message it sends.
+// A transport serves one thread at a time.
+template<group_backend G>
+class basic_transport
+{
+    public:
+        virtual ~basic_transport() = default;
+
+        // Sends out's messages from index from on and replaces them with the messages received
+        virtual void carry(vector<basic_message<G>>& out, size_t from, path_store& paths) = 0;
+
+        [[nodiscard]] virtual transport_kind kind() const = 0;
+        [[nodiscard]] const transport_stats& stats() const { return counters; }
+        void reset_stats() { counters = {}; }
+
+    protected:
+        transport_stats counters;
+};
+
+using transport = basic_transport<group>;
+
+// A fresh transport of the kind; the relayed kinds start their relay process here and throw
+// runtime_error if the system refuses the channel or the process
+template<group_backend G = group>
+unique_ptr<basic_transport<G>> make_transport(transport_kind kind);
+
+transport_kind parse_transport_kind(const string&);
+const char *transport_name(transport_kind);
+
+#endif
@@ -3,152 +3,250 @@
 #include <random>
 #include <tuple>
 #include <set>
-#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <bit>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <utility>
 #include "util.h"
+#include "random.h"
+#include "flat_hash.h"
+#include "profile.h"
+#include "thread_pool.h"
 
 using namespace std;
 
-vector<int> first_primes = {   2, 3, 5, 7, 11, 13, 17, 19, 23, 29,
-                                    31, 37, 41, 43, 47, 53, 59, 61, 67,
-                                    71, 73, 79, 83, 89, 97, 101, 103,
-                                    107, 109, 113, 127, 131, 137, 139,
-                                    149, 151, 157, 163, 167, 173, 179,
-                                    181, 191, 193, 197, 199, 211, 223,
-                                    227, 229, 233, 239, 241, 251, 257,
-                                    263, 269, 271, 277, 281, 283, 293,
-                                    307, 311, 313, 317, 331, 337, 347, 349 };
-
-int mulMod(int a, int b, int m) {
-    int res = 0;
-    while (a != 0) {
-        if (a & 1) res = (res + b) % m;
-        a >>= 1;
-        b = (b << 1) % m;
+namespace
+{
+    // Odd primes below 2^7, by the sieve of Eratosthenes. Sieving with them leaves about a quarter of
+    // the odd candidates for Miller-Rabin; larger primes remove too few to pay for their remainders.
+    const vector<uint32_t>& sieving_primes()
+    {
+        static const vector<uint32_t> primes = [] {
+            uint32_t const bound = 1 << 7;
+            vector<bool> composite(bound);
+            vector<uint32_t> found;
+            for (uint32_t i = 3; i < bound; i += 2)
+            {
+                if (composite[i]) continue;
+                found.push_back(i);
+                for (uint32_t j = i * i; j < bound; j += 2 * i) composite[j] = true;
+            }
+            return found;
+        }();
+        return primes;
     }
-    return res;
-}
 
-int powMod(int a, int b, int n) {
-    int x = 1;
-    a %= n;
-    while (b > 0) {
-        if (b & 1) x = mulMod(x, a, n);
-        a = mulMod(a, a, n);
-        b >>= 1;
+    // a^-1 mod s for a prime s by the extended Euclidean algorithm, or 0 where s divides a
+    uint32_t inverseMod(uint32_t a, uint32_t s)
+    {
+        int32_t t = 0, next_t = 1;
+        auto r = (int32_t) s, next_r = (int32_t) a;
+        while (next_r != 0)
+        {
+            int32_t const quotient = r / next_r;
+            t = exchange(next_t, t - quotient * next_t);
+            r = exchange(next_r, r - quotient * next_r);
+        }
+        return r != 1 ? 0 : (uint32_t) (t < 0 ? t + (int32_t) s : t);
     }
-    return x % n;
-}
 
-template <typename T>
-tuple<mt19937, uniform_int_distribution<T>> makeDistribution(T lower, T upper)
-{
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<T> distr(lower, upper);
-    return { gen, distr };
+    // Sieve of the progressions a + k*step for one step. The step's inverse modulo every sieving prime
+    // is found once, so a window then costs two remainders per prime and the marks.
+    class progression_sieve
+    {
+        public:
+            explicit progression_sieve(uint64_t step) : step(step)
+            {
+                for (uint32_t s : sieving_primes()) inverse.push_back(inverseMod((uint32_t) (step % s), s));
+            }
+
+            // Marks composite[k] for every k < count where a + k*step has a sieving prime factor other
+            // than itself; the caller keeps the progression below 2^64
+            void operator()(uint64_t a, size_t count, vector<uint8_t>& composite) const
+            {
+                composite.assign(count, 0);
+                auto const &primes = sieving_primes();
+                for (size_t i = 0; i < primes.size(); ++i)
+                {
+                    uint32_t const s = primes[i];
+                    auto const a_mod = (uint32_t) (a % s);
+                    if (inverse[i] == 0)
+                    {
+                        // Every term has the residue of a
+                        if (a_mod == 0) for (size_t k = 0; k < count; ++k) if (a + k * step != s) composite[k] = 1;
+                        continue;
+                    }
+                    // a + k*step = 0 (mod s) exactly when k = -a / step (mod s)
+                    for (size_t k = (uint64_t) (s - a_mod) * inverse[i] % s; k < count; k += s)
+                        if (a + k * step != s) composite[k] = 1;
+                }
+            }
+
+        private:
+            uint64_t step;
+            vector<uint32_t> inverse;   // by sieving prime, step^-1 mod s, or 0 where s divides the step
+    };
+
+    // Candidates sieved at once: a few prime gaps at 64 bits, and a window without a prime just draws again
+    constexpr size_t sieve_window = 64;
 }
 
-int getRandomInDist(int lower, int upper)
+uint64_t getRandomInDist(uint64_t lower, uint64_t upper)
 {
-    auto [gen, distr] = makeDistribution(lower, upper);
-    return distr(gen);
+    return lower + getRandomBelow(upper - lower + 1);
 }
 
-int getRandomOfSize(int bits = 64) {
+uint64_t getRandomOfSize(int bits = 64) {
     if (bits < 2) return 0;
-    auto [gen, distr] = makeDistribution<int>(0, (1 << (bits - 1)) - 1);
-    return distr(gen) | (1 << (bits - 1));
+    return getRandomBelow(1ULL << (bits - 1)) | (1ULL << (bits - 1));
 }
 
-int getRandomInGroup(int g, int q, int p)
+uint64_t getRandomInGroup(const group& G)
 {
-    auto [gen, distr] = makeDistribution(0, q - 1);
-    return powMod(g, distr(gen), p);
+    uint64_t e;
+    {
+        PROFILE_SCOPE(probe::random);
+        PROFILE_COUNT(tally::random_draws, 1);
+        e = getRandomBelow(G.q);
+    }
+    return G.pow_g(e);
 }
 
-int getRandomInGroup(group G) { return getRandomInGroup(G.g, G.q, G.p); }
-
-int getLowLevelPrime(int bits = 64) {
-    while (true) {
-        int candidate = getRandomOfSize(bits);
-        bool is_prime = true;
-        for (int first_prime : first_primes) {
-            if (candidate == first_prime) return candidate;
-            if (candidate % first_prime == 0) {
-                is_prime = false;
-                break;
-            }
-        }
-        if (is_prime) return candidate;
+void fillRandomInGroup(const group& G, span<uint64_t> out)
+{
+    {
+        PROFILE_SCOPE(probe::random);
+        PROFILE_COUNT(tally::random_draws, out.size());
+        fillRandomBelow(G.q, out);
     }
+    for (auto &v : out) v = G.pow_g(v);
 }
 
-bool trialComposite(int a, int even_c, int to_test, int max_div_2) {
-    if (powMod(a, even_c, to_test) == 1) return false;
-    for (int i = 0; i < max_div_2; ++i) {
-        int temp = static_cast<int>(1) << i;
-        if (powMod(a, temp * even_c, to_test) == to_test - 1) return false;
+// Whether a is a Miller-Rabin witness for the compositeness of n, where n - 1 = d * 2^s with d odd:
+// a^d is computed once and then squared s - 1 times, all in Montgomery form
+bool trialComposite(const montgomery& mont, uint64_t a, uint64_t d, int s) {
+    uint64_t const one = mont.one(), minus_one = mont.modulus() - one;
+    uint64_t x = mont.pow(mont.to(a), d);
+    if (x == one || x == minus_one) return false;
+    for (int i = 1; i < s; ++i) {
+        x = mont.mul(x, x);
+        if (x == minus_one) return false;
+        if (x == one) return true;
     }
     return true;
 }
 
-bool millerRabinTest(int to_test, int accuracy = 20) {
-    int max_div_2 = 0;
-    int even_c = to_test - 1;
-    while (even_c % 2 == 0) {
-        even_c >>= 1;
-        max_div_2++;
-    }
-
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<int> distr(2, to_test);
+// Deterministic for every 64-bit n: no composite below 2^64 passes all of these seven bases (Sinclair).
+// Bases that are multiples of n say nothing and are skipped.
+bool millerRabinTest(uint64_t n) {
+    if (n < 4) return n == 2 || n == 3;
+    if (n % 2 == 0) return false;
+    uint64_t d = n - 1;
+    int const s = countr_zero(d);
+    d >>= s;
 
-    for (int i = 0; i < accuracy; ++i) {
-        int a = distr(gen);
-        if (trialComposite(a, even_c, to_test, max_div_2)) {
-            return false;
-        }
+    montgomery const mont(n);
+    for (uint64_t base : { 2ULL, 325ULL, 9375ULL, 28178ULL, 450775ULL, 9780504ULL, 1795265022ULL }) {
+        uint64_t const a = base % n;
+        if (a == 0) continue;
+        if (trialComposite(mont, a, d, s)) return false;
     }
     return true;
 }
 
-int getBigPrime(int bits = 64) {
+// The first prime from a random odd bits-bit start, searching a sieved window at a time
+uint64_t getBigPrime(int bits = 64) {
+    if (bits < 2 || bits > 64) throw invalid_argument("getBigPrime: needs 2 to 64 bits");
+    uint64_t const top = bits == 64 ? UINT64_MAX : (1ULL << bits) - 1;
+    static const progression_sieve sieve(2);
+    thread_local vector<uint8_t> composite;
     while (true) {
-        int candidate = getLowLevelPrime(bits);
-        if (millerRabinTest(candidate)) return candidate;
+        uint64_t const start = getRandomOfSize(bits) | 1;
+        auto const count = (size_t) min<uint64_t>(sieve_window, (top - start) / 2 + 1);
+        sieve(start, count, composite);
+        for (size_t k = 0; k < count; ++k)
+            if (!composite[k] && millerRabinTest(start + 2 * k)) return start + 2 * k;
     }
 }
 
+// Finds p = q*r + 1 with q a q_size-bit prime and r an even r_size-bit cofactor; p must stay below 2^62.
+// The cofactors are tried in sieved runs r, r + 2, ..., so only those that leave p free of small
+// factors reach Miller-Rabin.
 group getGroupParameters(int q_size, int r_size) {
-    int q = getBigPrime(q_size);
+    if (q_size + r_size > 62) throw invalid_argument("group parameters exceed 62 bits");
+    if (q_size < 2 || r_size < 2) throw invalid_argument("group parameters need at least 2 bits each");
+    uint64_t q = getBigPrime(q_size);
+    uint64_t const top = (1ULL << r_size) - 2;     // largest even r_size-bit cofactor
+    progression_sieve const sieve(2 * q);
+    thread_local vector<uint8_t> composite;
     while (true) {
-        int r = getRandomInDist(2, powMod(2, r_size, UINT16_MAX));
-        int p = q * r + 1;
+        uint64_t const first = getRandomOfSize(r_size) & ~1ULL;
+        auto const count = (size_t) min<uint64_t>(sieve_window, (top - first) / 2 + 1);
+        sieve(q * first + 1, count, composite);
+        for (size_t k = 0; k < count; ++k) {
+            if (composite[k]) continue;
+            uint64_t const r = first + 2 * k;
+            uint64_t const p = q * r + 1;
+            if (!millerRabinTest(p)) continue;
 
-        if (!millerRabinTest(p)) continue;
+            uint64_t h = getRandomInDist(2, p - 1);
+            uint64_t g = powMod(h, r, p);
 
-        int h = getRandomInDist(2, p - 1);
-        int g = powMod(h, r, p);
-
-        if (g != 1) return group{p, q, r, h, g};
+            if (g != 1) return {p, q, r, h, g};
+        }
     }
 }
 
-double average_degree(const vector<vector<int>>& graph) {
-    std::unordered_set<int> unique_nodes;
-    size_t edge_count = 0;
-    for (const auto& edge : graph) {
-        if (edge.size() != 2) continue;  // skip malformed edges
-        unique_nodes.insert(edge[0]);
-        unique_nodes.insert(edge[1]);
-        edge_count++;
+bool validGroupParameters(const group& G, int q_size, int r_size) {
+    if (q_size < 2 || r_size < 2 || q_size + r_size > 62) return false;
+    if ((int) bit_width(G.q) != q_size || (int) bit_width(G.r) != r_size || G.r % 2 != 0) return false;
+    if (G.p != G.q * G.r + 1 || !millerRabinTest(G.q) || !millerRabinTest(G.p)) return false;
+    // g = h^r is then 1 or of order q, as g^q = h^(p - 1) = 1
+    return G.h >= 2 && G.h < G.p && G.g != 1 && G.g == powMod(G.h, G.r, G.p);
+}
+
+group cachedGroupParameters(int q_size, int r_size, const string& path) {
+    if (!path.empty()) {
+        ifstream in(path);
+        string line;
+        while (getline(in, line)) {
+            istringstream fields(line);
+            int q_bits, r_bits;
+            uint64_t p, q, r, h, g;
+            if (!(fields >> q_bits >> r_bits >> p >> q >> r >> h >> g) || q_bits != q_size || r_bits != r_size) continue;
+            group G(p, q, r, h, g);
+            if (validGroupParameters(G, q_size, r_size)) return G;
+        }
     }
-    if (unique_nodes.empty()) return 0.0;
-    return (double) edge_count / (double) unique_nodes.size();
+
+    // Drawn from a stream of the sizes alone, so a cache hit and a miss give the same group; the
+    // thread's own stream is left where it was
+    uint64_t state = ((uint64_t) q_size << 32 | (uint64_t) r_size) ^ 0x67726F7570ULL;
+    engine const saved = threadEngine();
+    threadEngine() = engine(splitmix64(state));
+    group G = getGroupParameters(q_size, r_size);
+    threadEngine() = saved;
+
+    if (!path.empty()) {
+        error_code ignored;
+        filesystem::path const file(path);
+        if (file.has_parent_path()) filesystem::create_directories(file.parent_path(), ignored);
+        // A cache that cannot be written only costs the next run the search again
+        ofstream(path, ios::app) << q_size << ' ' << r_size << ' ' << G.p << ' ' << G.q << ' ' << G.r << ' ' << G.h << ' ' << G.g << '\n';
+    }
+    return G;
+}
+
+double average_degree(const graph& g) {
+    if (g.size() == 0) return 0.0;
+    return (double) g.edges() / (double) g.size();
 }
 
-tuple<int, double, vector<vector<int>>> generate_graph(int size, int min_degree, int max_degree)
+tuple<int, double, graph> generate_graph(int size, int min_degree, int max_degree)
 {
     random_device dev;
     mt19937 rng(dev());
@@ -160,11 +258,12 @@ tuple<int, double, vector<vector<int>>> generate_graph(int size, int min_degree,
     double const standard_deviation  = average_bound_width / 3;
     normal_distribution<double> distribution(mean, standard_deviation);
 
-    vector<vector<int>> graph;
+    // Rows are generated in order, so they go straight into the CSR arrays
+    vector<size_t> offsets = { 0 };
+    vector<int> targets;
     int d_sum = 0;
     for(int i = 0; i < size; ++i)
     {
-        graph.emplace_back();
         int d = d_dist(rng);
         d_sum += d;
         set<int> seen;
@@ -175,57 +274,135 @@ tuple<int, double, vector<vector<int>>> generate_graph(int size, int min_degree,
                 k = (int) dist(rng);
             } while (seen.contains(k) || k == i);
             seen.insert(k);
-            graph.at(i).emplace_back(k);
+            targets.emplace_back(k);
         }
+        offsets.emplace_back(targets.size());
     }
-    return { d_sum, (double) d_sum / (double) size, graph };
+    return { d_sum, (double) d_sum / (double) size, graph(std::move(offsets), std::move(targets)) };
 }
 
-// Generates graphs using the Barabási–Albert model
-tuple<int, double, vector<vector<int>>> generate_scale_free_graph(int m0, int m, int target_size)
+namespace
 {
-    random_device dev;
-    mt19937 rng(dev());
-    vector<vector<int>> graph;
-    uniform_int_distribution<int> edge_direction(0, 1);
-
-    for(int i = 0; i < m0; ++i)
+    // Barabási–Albert preferential attachment in the form of Batagelj and Brandes: every edge adds both
+    // endpoints to a repeated-endpoints array M, and a new edge picks its target as a uniform entry of M,
+    // i.e. proportionally to degree. Edge e fills M[2e] (its source) and M[2e + 1] (its target). The
+    // array is never stored: an entry is recomputed from a hash of (seed, e), so any edge can be
+    // resolved on its own, by any thread, in expected O(1) steps.
+    //
+    // The first edges form a complete directed graph over the m0 seed nodes; node i >= m0 then adds m
+    // to distinct targets, or to all i earlier nodes if there are fewer. A pick repeating an earlier
+    // one of the same node is drawn again with a further salt; M keeps every edge's first pick, so
+    // entries still resolve without looking at the other edges of their node.
+    class ba_model
     {
-        vector<int> neighbours;
-        for(int j = 0; j < m0; ++j) if(i != j) neighbours.emplace_back(j);
-        graph.emplace_back(neighbours);
-    }
+        public:
+            ba_model(int m0, int m, uint64_t seed) : m0(m0), m(m), seed(seed), seed_edges((uint64_t) m0 * (m0 - 1)) {}
 
-    int edges_in_m = m0*(m0-1);         // edges at initialisation
-    edges_in_m += m*(target_size-m0);   // edges in full graph
+            [[nodiscard]] int source(uint64_t e) const
+            {
+                return e < seed_edges ? (int) (e / (m0 - 1)) : m0 + (int) ((e - seed_edges) / m);
+            }
 
-    for(int i = m0; i < target_size; ++i)
-    {
-        uniform_int_distribution<int> dist(0, i - 1);
-        graph.emplace_back();
-        set<int> seen;
-        for(int j = 0; j < m; ++j)
-        {
-            int k;
-            do {
-                k = dist(rng);
-            } while (seen.contains(k));
-            if(edge_direction(rng) == 0) graph.at(i).emplace_back(k);
-            else graph.at(k).emplace_back(i);
-            seen.insert(k);
-        }
-    }
-    return { edges_in_m, (double) edges_in_m / (double) target_size, graph };
+            // Follows target entries back until a draw lands on a source entry or a seed edge; attempt k > 0
+            // is the k-th redraw of edge e's own pick, the entries it lands on are first picks
+            [[nodiscard]] int target(uint64_t e, uint64_t attempt = 0) const
+            {
+                while (e >= seed_edges)
+                {
+                    // Only endpoints of earlier nodes' edges are candidates, so there are no self-loops
+                    uint64_t const first = seed_edges + (uint64_t) (source(e) - m0) * m;
+                    uint64_t const r = below(draw(e, attempt == 0 ? 0 : attempt + 1), 2 * first);
+                    attempt = 0;
+                    if (r % 2 == 0) return source(r / 2);
+                    e = r / 2;
+                }
+                int const i = (int) (e / (m0 - 1)), j = (int) (e % (m0 - 1));
+                return j >= i ? j + 1 : j;
+            }
+
+            // Calls f(source, target) for every edge node i adds. Each edge points away from i with
+            // probability 1/2, as in the old generator.
+            template <typename F>
+            void node_edges(int i, F f) const
+            {
+                if (i < m0)
+                {
+                    for (int j = 0; j < m0; ++j) if (j != i) f(i, j);
+                    return;
+                }
+                uint64_t const first = seed_edges + (uint64_t) (i - m0) * m;
+                thread_local vector<int> seen;
+                seen.clear();
+                for (int j = 0; j < min(m, i); ++j)
+                {
+                    int k = target(first + j);
+                    for (uint64_t attempt = 1; find(seen.begin(), seen.end(), k) != seen.end(); ++attempt) k = target(first + j, attempt);
+                    seen.push_back(k);
+                    if (draw(first + j, 1) & 1) f(k, i);
+                    else f(i, k);
+                }
+            }
+
+        private:
+            int m0, m;
+            uint64_t seed, seed_edges;
+
+            // Salt 0 draws an edge's target, 1 its direction and 2 onwards the redraws of its target
+            [[nodiscard]] uint64_t draw(uint64_t e, uint64_t salt) const
+            {
+                uint64_t state = seed ^ mix64(mix64(e) + salt);
+                return splitmix64(state);
+            }
+
+            // Multiply-shift reduction to [0, bound); the bias is below bound / 2^64
+            static uint64_t below(uint64_t x, uint64_t bound) { return (uint64_t) (((unsigned __int128) x * bound) >> 64); }
+    };
+}
+
+// Generates graphs using the Barabási–Albert model. Edges are counted per source, then scattered
+// straight into the CSR targets and each row is sorted, so the graph depends only on the seed and
+// not on the pool or its size.
+tuple<int, double, graph> generate_scale_free_graph(int m0, int m, int target_size, uint64_t seed, thread_pool *pool)
+{
+    if (m0 < 2 || m < 1) throw invalid_argument("generate_scale_free_graph: needs m0 >= 2 and m >= 1");
+    int const n = max(target_size, m0);
+    ba_model const model(m0, m, seed);
+
+    // Nodes are handed out in blocks; the pool's workers steal blocks from each other
+    size_t const blocks = pool ? 8 * (size_t) pool->size() : 1;
+    auto for_blocks = [&](auto body) {
+        auto run = [&](size_t k, unsigned) {
+            for (int i = (int) (k * n / blocks); i < (int) ((k + 1) * n / blocks); ++i) body(i);
+        };
+        if (pool) pool->parallel_for(blocks, run);
+        else run(0, 0);
+    };
+
+    vector<size_t> offsets(n + 1, 0);
+    for_blocks([&](int i) {
+        model.node_edges(i, [&](int source, int) { atomic_ref<size_t>(offsets[source + 1]).fetch_add(1, memory_order_relaxed); });
+    });
+    for (int v = 0; v < n; ++v) offsets[v + 1] += offsets[v];
+
+    vector<int> targets(offsets[n]);
+    vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+    for_blocks([&](int i) {
+        model.node_edges(i, [&](int source, int target) {
+            targets[atomic_ref<size_t>(cursor[source]).fetch_add(1, memory_order_relaxed)] = target;
+        });
+    });
+    for_blocks([&](int v) { sort(targets.begin() + (ptrdiff_t) offsets[v], targets.begin() + (ptrdiff_t) offsets[v + 1]); });
+
+    auto const edges = (int) offsets[n];
+    return { edges, (double) edges / (double) n, graph(std::move(offsets), std::move(targets)) };
 }
 
-void print_graph(vector<vector<int>> graph)
+void print_graph(const graph& g)
 {
-    int idx = 0;
-    for(const auto& node: graph)
+    for(int v = 0; v < g.size(); ++v)
     {
-        cout << "node " << idx << ": ";
-        for(auto edge: node) cout << edge << " ";
+        cout << "node " << v << ": ";
+        for(auto target: g.neighbours(v)) cout << target << " ";
         cout << endl;
-        ++idx;
     }
 }
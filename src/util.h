@@ -5,30 +5,35 @@
 #include <cstdint>
 #include <vector>
 #include <random>
+#include <span>
 #include <bitset>
 #include <tuple>
+#include <string>
+#include "graph.h"
+#include "group.h"
+#include "modarith.h"
 
 using namespace std;
 
-struct group { int p, q, r, h, g; };
+class thread_pool;
 
-int mulMod(int, int, int);
-int powMod(int, int, int) ;
-
-template <typename T>
-tuple<mt19937, uniform_int_distribution<T>> makeDistribution(T lower, T upper);
-
-int getRandomInDist(int lower, int upper);
-int getRandomOfSize(int) ;
-int getRandomInGroup(group);
-int getLowLevelPrime(int);
-bool trialComposite(int, int, int, int);
-bool millerRabinTest(int, int);
-int getBigPrime(int);
+uint64_t getRandomInDist(uint64_t lower, uint64_t upper);
+uint64_t getRandomOfSize(int) ;
+uint64_t getRandomInGroup(const group&);
+void fillRandomInGroup(const group&, span<uint64_t>);
+bool trialComposite(const montgomery&, uint64_t, uint64_t, int);
+bool millerRabinTest(uint64_t);
+uint64_t getBigPrime(int);
 group getGroupParameters(int, int);
-double average_degree(const vector<vector<int>>& graph);
-tuple<int, double, vector<vector<int>>> generate_graph(int, int, int);
-tuple<int, double, vector<vector<int>>> generate_scale_free_graph(int, int, int);
-void print_graph(vector<vector<int>>);
+// Whether the set is a group of the given sizes: q and p = q*r + 1 prime and g = h^r a generator of order q
+bool validGroupParameters(const group&, int q_size, int r_size);
+// Parameters of the given sizes, a pure function of the sizes: read from the cache file if it holds a
+// valid set, otherwise searched for and appended to it. An empty path skips the cache.
+group cachedGroupParameters(int q_size, int r_size, const string& path);
+double average_degree(const graph&);
+tuple<int, double, graph> generate_graph(int, int, int);
+// Barabási–Albert graph on max(size, m0) nodes, reproducible from the seed; a pool spreads the work
+tuple<int, double, graph> generate_scale_free_graph(int m0, int m, int size, uint64_t seed, thread_pool *pool = nullptr);
+void print_graph(const graph&);
 
 #endif
\ No newline at end of file
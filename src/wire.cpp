@@ -0,0 +1,151 @@
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include "wire.h"
+
+using namespace std;
+
+namespace
+{
+    constexpr uint8_t type_mask = 0x3, has_valid_to = 0x4;
+
+    // Longest encoding of an element: a 64-bit varint, or the limbs in full
+    template<typename E>
+    constexpr size_t max_element = is_same_v<E, uint64_t> ? 10 : sizeof(E);
+
+    // Fixed fields of a message at their longest: header, four 32-bit fields, r and gx, hop,
+    // valid_to and the path length
+    template<group_backend G>
+    constexpr size_t max_fixed = 1 + 4 * 5 + 10 + max_element<typename G::element> + 2 * 3 + 5;
+
+    uint8_t *put(uint64_t value, uint8_t *to)
+    {
+        while (value >= 0x80)
+        {
+            *to++ = (uint8_t) (value | 0x80);
+            value >>= 7;
+        }
+        *to++ = (uint8_t) value;
+        return to;
+    }
+
+    int get_int(span<const uint8_t>& in)
+    {
+        uint64_t const value = get_varint(in);
+        if (value > INT32_MAX) throw runtime_error("wire: field out of range");
+        return (int) value;
+    }
+
+    template<size_t N>
+    uint8_t *put(const wide_uint<N>& value, uint8_t *to)
+    {
+        static_assert(endian::native == endian::little, "limbs are copied as they lie in memory");
+        memcpy(to, value.limb, sizeof(value.limb));
+        return to + sizeof(value.limb);
+    }
+
+    template<typename E>
+    E get_element(span<const uint8_t>& in)
+    {
+        if constexpr (is_same_v<E, uint64_t>) return get_varint(in);
+        else
+        {
+            E value;
+            if (in.size() < sizeof(value.limb)) throw runtime_error("wire: truncated message");
+            memcpy(value.limb, in.data(), sizeof(value.limb));
+            in = in.subspan(sizeof(value.limb));
+            return value;
+        }
+    }
+}
+
+void put_varint(uint64_t value, vector<uint8_t>& out)
+{
+    uint8_t bytes[10];
+    out.insert(out.end(), bytes, put(value, bytes));
+}
+
+uint64_t get_varint(span<const uint8_t>& in)
+{
+    const uint8_t *at = in.data(), *const end = at + in.size();
+    uint64_t value = 0;
+    for (int shift = 0; at != end && shift < 64; shift += 7)
+    {
+        uint8_t const byte = *at++;
+        value |= (uint64_t) (byte & 0x7F) << shift;
+        if (byte < 0x80)
+        {
+            in = { at, end };
+            return value;
+        }
+    }
+    throw runtime_error(at == end ? "wire: truncated message" : "wire: varint longer than 64 bits");
+}
+
+template<group_backend G>
+void encode(const basic_message<G>& msg, const path_store& paths, vector<uint8_t>& out)
+{
+    thread_local vector<int> nodes;
+    nodes.clear();
+    if (msg.t == p || msg.t == broadcast) paths.nodes(msg.path, nodes);
+
+    // Written in place past the end and trimmed after, rather than pushed byte by byte
+    size_t const start = out.size();
+    out.resize(start + max_fixed<G> + 5 * nodes.size());
+    uint8_t *to = out.data() + start;
+    *to++ = (uint8_t) (msg.t | (msg.valid_to != UINT16_MAX ? has_valid_to : 0));
+    if (msg.t != broadcast)
+    {
+        to = put((uint32_t) msg.source, to);
+        to = put((uint32_t) msg.target, to);
+        to = put(msg.r, to);
+        to = put(msg.gx, to);
+    }
+    if (msg.t == f) to = put((uint32_t) msg.l, to);
+    to = put(msg.hop, to);
+    if (msg.t == p || msg.t == broadcast)
+    {
+        to = put(nodes.size(), to);
+        for (int v : nodes) to = put((uint32_t) v, to);
+    }
+    if (msg.valid_to != UINT16_MAX) to = put(msg.valid_to, to);
+    out.resize((size_t) (to - out.data()));
+}
+
+template<group_backend G>
+basic_message<G> decode(span<const uint8_t>& in, path_store& paths)
+{
+    if (in.empty()) throw runtime_error("wire: truncated message");
+    uint8_t const header = in.front();
+    in = in.subspan(1);
+    if (header & ~(type_mask | has_valid_to)) throw runtime_error("wire: bad message header");
+
+    basic_message<G> msg;
+    msg.t = (type) (header & type_mask);
+    if (msg.t != broadcast)
+    {
+        msg.source = get_int(in);
+        msg.target = get_int(in);
+        msg.r = get_varint(in);
+        msg.gx = get_element<typename G::element>(in);
+    }
+    if (msg.t == f) msg.l = get_int(in);
+    msg.hop = (uint16_t) get_varint(in);
+    if (msg.t == p || msg.t == broadcast)
+    {
+        uint64_t const length = get_varint(in);
+        if (length > in.size()) throw runtime_error("wire: truncated path");
+        for (uint64_t i = 0; i < length; ++i) msg.path = paths.extend(msg.path, get_int(in));
+    }
+    if (header & has_valid_to) msg.valid_to = (uint16_t) get_varint(in);
+    return msg;
+}
+
+template void encode(const basic_message<small_group>&, const path_store&, vector<uint8_t>&);
+template void encode(const basic_message<group>&, const path_store&, vector<uint8_t>&);
+template void encode(const basic_message<modp2048>&, const path_store&, vector<uint8_t>&);
+template void encode(const basic_message<modp3072>&, const path_store&, vector<uint8_t>&);
+template basic_message<small_group> decode(span<const uint8_t>&, path_store&);
+template basic_message<group> decode(span<const uint8_t>&, path_store&);
+template basic_message<modp2048> decode(span<const uint8_t>&, path_store&);
+template basic_message<modp3072> decode(span<const uint8_t>&, path_store&);
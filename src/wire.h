@@ -0,0 +1,38 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "message.h"
+#include "path.h"
+
+using namespace std;
+
+// Compact binary encoding of messages as they would travel between hosts. A message is a header
+// byte, the message type in the low two bits and bit 2 set when valid_to is below its maximum,
+// followed by the fields its type uses as LEB128 varints:
+//   forward    source, target, r, gx, l, hop
+//   backward   source, target, r, gx, hop
+//   publish    source, target, r, gx, hop, path
+//   broadcast  hop, path
+// and valid_to if bit 2 is set. A path is its length followed by its nodes, front first; it is
+// spelled out in full, since the receiver does not share the sender's path store. Messages are
+// self-delimiting, so a batch is their plain concatenation. A multi-precision gx is not a varint
+// but its limbs in full, least significant first, little-endian.
+
+// LEB128 varints on their own, for formats built around the message encoding; get_varint advances in
+// past the value and throws runtime_error on a truncated or overlong one
+void put_varint(uint64_t value, vector<uint8_t>& out);
+uint64_t get_varint(span<const uint8_t>& in);
+
+// Appends the encoding of msg, whose path lives in paths
+template<group_backend G>
+void encode(const basic_message<G>& msg, const path_store& paths, vector<uint8_t>& out);
+
+// Decodes the message at the front of in and advances in past it, adding its path to paths.
+// Throws runtime_error on a truncated or malformed message.
+template<group_backend G>
+basic_message<G> decode(span<const uint8_t>& in, path_store& paths);
+
+#endif
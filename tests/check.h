@@ -0,0 +1,43 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <functional>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// Minimal self-contained test harness: each case checks the code against a slower reference and
+// reports every mismatch; a case passes if it reports none
+struct test_state
+{
+    int failures = 0;
+
+    void fail(const string& what, const char *file, int line);
+};
+
+using test_fn = function<void(test_state&)>;
+
+bool register_test(const string& name, test_fn fn);
+
+#define TEST(name)                                                                     \
+    static void name(test_state&);                                                     \
+    [[maybe_unused]] static const bool name##_registered = register_test(#name, name); \
+    static void name(test_state& state)
+
+// Reports a failure with both sides and goes on with the case; expected is the reference value
+#define CHECK_EQ(actual, expected)                                                                   \
+    do {                                                                                             \
+        auto const &check_actual = (actual);                                                         \
+        auto const &check_expected = (expected);                                                     \
+        if (!(check_actual == check_expected))                                                       \
+        {                                                                                            \
+            ostringstream check_what;                                                                \
+            check_what << #actual << " == " << check_actual << ", expected " << check_expected;      \
+            state.fail(check_what.str(), __FILE__, __LINE__);                                        \
+        }                                                                                            \
+    } while (false)
+
+#define CHECK(condition) do { if (!(condition)) state.fail(#condition, __FILE__, __LINE__); } while (false)
+
+#endif
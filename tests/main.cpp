@@ -0,0 +1,53 @@
+#include <iostream>
+#include <vector>
+#include "check.h"
+#include "random.h"
+
+using namespace std;
+
+namespace
+{
+    constexpr uint64_t test_seed = 1;
+    constexpr int max_reported = 10;   // failures printed per case
+
+    vector<pair<string, test_fn>>& registry()
+    {
+        static vector<pair<string, test_fn>> tests;
+        return tests;
+    }
+}
+
+void test_state::fail(const string& what, const char *file, int line)
+{
+    if (++failures <= max_reported) cerr << "  " << file << ":" << line << ": " << what << '\n';
+}
+
+bool register_test(const string& name, test_fn fn)
+{
+    registry().emplace_back(name, std::move(fn));
+    return true;
+}
+
+// Runs every registered test whose name contains the optional filter argument; the exit status is
+// the number of failed cases
+int main(int argc, char *argv[])
+{
+    string const filter = argc > 1 ? argv[1] : "";
+    // Random inputs are drawn from streams of this seed, so a failure reproduces
+    setMasterSeed(test_seed);
+
+    int failed = 0, run = 0;
+    for (const auto& [name, fn] : registry())
+    {
+        if (name.find(filter) == string::npos) continue;
+        test_state state;
+        fn(state);
+        ++run;
+        if (state.failures) ++failed;
+        cout << (state.failures ? "FAIL " : "ok   ") << name;
+        if (state.failures) cout << " (" << state.failures << " mismatches)";
+        cout << endl;
+    }
+    cout << run - failed << " of " << run << " tests passed" << endl;
+    return failed;
+}
@@ -0,0 +1,34 @@
+#include "arena.h"
+#include "check.h"
+#include "flat_hash.h"
+
+using namespace std;
+
+// A growing map frees its old table, which used() and peak() must not keep counting
+TEST(arena_counts_live_bytes)
+{
+    arena a;
+    {
+        flat_map<uint64_t, uint16_t> map(&a);
+        for (uint64_t k = 0; k < 100000; ++k) map.insert(k, 1);
+        CHECK_EQ(a.used(), map.bytes());
+        // While growing, the old table is live next to the new one of twice its size
+        CHECK_EQ(a.peak(), map.bytes() + map.bytes() / 2);
+    }
+    CHECK_EQ(a.used(), 0);
+    a.rewind();
+    a.reset_peak();
+    CHECK_EQ(a.peak(), 0);
+}
+
+// The size the incremental search reports for the learned edges is that of a set actually built
+TEST(flat_set_bytes_for)
+{
+    flat_set<uint64_t> set;
+    CHECK_EQ(flat_set<uint64_t>::bytes_for(0), set.bytes());
+    for (uint64_t k = 1; k <= 5000; ++k)
+    {
+        set.insert(mix64(k));
+        CHECK_EQ(flat_set<uint64_t>::bytes_for(k), set.bytes());
+    }
+}
@@ -0,0 +1,184 @@
+#include <vector>
+#include "check.h"
+#include "group.h"
+#include "modarith.h"
+#include "multiprecision.h"
+#include "powbatch.h"
+#include "random.h"
+#include "util.h"
+
+using namespace std;
+
+namespace
+{
+    // Square and multiply on mulMod; powMod itself goes through Montgomery for odd moduli
+    uint64_t reference_pow(uint64_t a, uint64_t e, uint64_t n)
+    {
+        uint64_t x = 1 % n;
+        a %= n;
+        for (; e > 0; e >>= 1)
+        {
+            if (e & 1) x = mulMod(x, a, n);
+            a = mulMod(a, a, n);
+        }
+        return x;
+    }
+
+    // Random odd moduli of the given width, with the top bit set
+    uint64_t random_modulus(int bits)
+    {
+        uint64_t const top = 1ULL << (bits - 1);
+        return top | getRandomBelow(top) | 1;
+    }
+
+    // Odd moduli from 3 up to 2^64 - 1, including random ones of the widths the kernels switch at
+    vector<uint64_t> test_moduli()
+    {
+        vector<uint64_t> moduli = { 3, 5, 65537, (1ULL << 31) - 1, (1ULL << 52) - 1, (1ULL << 61) - 1, UINT64_MAX, UINT64_MAX - 58 };
+        for (int bits : { 8, 20, 31, 32, 40, 52, 53, 63, 64 })
+            for (int k = 0; k < 4; ++k) moduli.push_back(random_modulus(bits));
+        return moduli;
+    }
+
+    // Operands the reductions get wrong first: 0, 1, n - 1 and then random ones
+    uint64_t operand(int k, uint64_t n)
+    {
+        switch (k)
+        {
+            case 0: return 0;
+            case 1: return 1 % n;
+            case 2: return n - 1;
+            default: return getRandomBelow(n);
+        }
+    }
+
+    // a*b mod n for n < 2^127, by doubling and adding so nothing overflows
+    unsigned __int128 reference_mul(unsigned __int128 a, unsigned __int128 b, unsigned __int128 n)
+    {
+        unsigned __int128 x = 0;
+        for (int i = 127; i >= 0; --i)
+        {
+            x = x * 2 % n;
+            if ((b >> i) & 1) x = (x + a) % n;
+        }
+        return x;
+    }
+
+    wide_uint<2> to_wide(unsigned __int128 x)
+    {
+        wide_uint<2> w;
+        w.limb[0] = (uint64_t) x;
+        w.limb[1] = (uint64_t) (x >> 64);
+        return w;
+    }
+}
+
+TEST(montgomery_matches_mulmod)
+{
+    for (uint64_t n : test_moduli())
+    {
+        montgomery const mont(n);
+        for (int k = 0; k < 200; ++k)
+        {
+            uint64_t const a = operand(k, n), b = operand(k / 3, n), e = getRandomBelow(UINT64_MAX);
+            CHECK_EQ(mont.from(mont.to(a)), a);
+            CHECK_EQ(mont.from(mont.mul(mont.to(a), mont.to(b))), mulMod(a, b, n));
+            CHECK_EQ(mont.from(mont.pow(mont.to(a), e)), reference_pow(a, e, n));
+            CHECK_EQ(powMod(a, e, n), reference_pow(a, e, n));
+        }
+    }
+}
+
+// Known answers for the group's products and powers
+TEST(group_matches_mulmod)
+{
+    reseedThread(0);
+    for (auto [q_size, r_size] : { pair{ 16, 15 }, pair{ 20, 40 } })
+    {
+        group const G = getGroupParameters(q_size, r_size);
+        for (int k = 0; k < 1000; ++k)
+        {
+            uint64_t const a = operand(k, G.p), b = operand(k / 3, G.p), e = getRandomBelow(G.q);
+            CHECK_EQ(G.mul(a, b), mulMod(a, b, G.p));
+            CHECK_EQ(G.pow(a, e), reference_pow(a, e, G.p));
+            CHECK_EQ(G.pow_g(e), reference_pow(G.g, e, G.p));
+        }
+        CHECK_EQ(G.pow_g(G.q), 1);
+        if (G.p >> 32) continue;
+
+        small_group const S(G);
+        for (int k = 0; k < 1000; ++k)
+        {
+            uint64_t const a = operand(k, G.p), b = operand(k / 3, G.p), e = getRandomBelow(UINT64_MAX);
+            CHECK_EQ(S.mul(a, b), mulMod(a, b, G.p));
+            CHECK_EQ(S.pow(a, e), reference_pow(a, e, G.p));
+        }
+    }
+}
+
+// Every kernel the CPU has against the scalar reference, on lane counts that leave partial vectors
+TEST(pow_batcher_kernels)
+{
+    for (pow_kernel kernel : { pow_kernel::scalar, pow_kernel::avx2, pow_kernel::avx512 })
+        for (uint64_t n : test_moduli())
+        {
+            if (!pow_batcher::supported(kernel, n)) continue;
+            pow_batcher const batch(n, kernel);
+            for (size_t lanes : { 1, 3, 8, 37, 64 })
+            {
+                vector<uint64_t> bases(lanes), exps(lanes), out(lanes);
+                for (size_t i = 0; i < lanes; ++i)
+                {
+                    bases[i] = operand((int) i, n);
+                    exps[i] = i == 4 ? 0 : i == 5 ? 1 : getRandomBelow(UINT64_MAX);
+                }
+                batch(bases, exps, out);
+                for (size_t i = 0; i < lanes; ++i) CHECK_EQ(out[i], reference_pow(bases[i], exps[i], n));
+            }
+        }
+}
+
+TEST(wide_montgomery_matches_reference)
+{
+    // One limb against mulMod
+    for (uint64_t n : test_moduli())
+    {
+        wide_montgomery<1> const mont{ wide_uint<1>(n) };
+        for (int k = 0; k < 200; ++k)
+        {
+            uint64_t const a = operand(k, n), b = operand(k / 3, n), e = getRandomBelow(UINT64_MAX);
+            CHECK_EQ(mont.from(mont.mul(mont.to(wide_uint<1>(a)), mont.to(wide_uint<1>(b)))).limb[0], mulMod(a, b, n));
+            CHECK_EQ(mont.from(mont.pow(mont.to(wide_uint<1>(a)), wide_uint<1>(e))).limb[0], reference_pow(a, e, n));
+        }
+    }
+
+    // Two limbs against 128-bit arithmetic
+    for (int k = 0; k < 20; ++k)
+    {
+        auto const n = ((unsigned __int128) (random_modulus(63)) << 64) | getRandomBelow(UINT64_MAX) | 1;
+        wide_montgomery<2> const mont(to_wide(n));
+        for (int j = 0; j < 100; ++j)
+        {
+            auto const a = (((unsigned __int128) getRandomBelow(UINT64_MAX) << 64) | getRandomBelow(UINT64_MAX)) % n;
+            auto const b = (((unsigned __int128) getRandomBelow(UINT64_MAX) << 64) | getRandomBelow(UINT64_MAX)) % n;
+            CHECK(mont.from(mont.mul(mont.to(to_wide(a)), mont.to(to_wide(b)))) == to_wide(reference_mul(a, b, n)));
+        }
+    }
+
+    // The RFC 3526 primes are safe and 2 is a quadratic residue, so 2 has order q = (p - 1) / 2
+    modp2048 const G = modp2048::rfc3526();
+    wide_uint<32> q_minus_1 = G.q;
+    q_minus_1.limb[0] -= 1;
+    auto const one = modp2048::element(1);
+    CHECK(G.mont.from(G.mont.pow(G.mont.to(G.g), G.q)) == one);
+    CHECK(!(G.mont.from(G.mont.pow(G.mont.to(G.g), q_minus_1)) == one));
+    modp2048::element x = G.g;
+    for (int k = 0; k < 64; ++k) x = G.mul(x, G.g);
+    CHECK(x == G.pow(G.g, modp2048::exponent(65)));
+
+    // An exponent takes a fresh draw for each of its limbs
+    vector<uint64_t> draws(modp2048::exponent_draws);
+    G.random(draws);
+    modp2048::exponent const e = G.to_exponent(draws);
+    for (size_t i = 0; i < draws.size(); ++i) CHECK_EQ(e.limb[i], draws[i]);
+}
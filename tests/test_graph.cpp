@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <vector>
+#include "check.h"
+#include "graph.h"
+#include "thread_pool.h"
+#include "util.h"
+
+using namespace std;
+
+// Every node past the seed adds m edges to distinct earlier nodes, whatever the pool
+TEST(scale_free_graph_edges)
+{
+    thread_pool pool(4);
+    for (auto [m0, m] : { pair{ 2, 1 }, pair{ 3, 3 }, pair{ 4, 3 }, pair{ 5, 5 } })
+        for (uint64_t seed = 1; seed <= 4; ++seed)
+        {
+            constexpr int n = 200;
+            auto const [edges, degree, g] = generate_scale_free_graph(m0, m, n, seed);
+            CHECK_EQ(edges, m0 * (m0 - 1) + m * (n - m0));
+
+            // No node links to itself, and none past the seed twice to the same earlier node in either direction
+            vector<vector<int>> linked(n);
+            for (int v = 0; v < g.size(); ++v)
+                for (int w : g.neighbours(v))
+                {
+                    CHECK(v != w);
+                    linked[max(v, w)].push_back(min(v, w));
+                }
+            for (int v = m0; v < n; ++v)
+            {
+                sort(linked[v].begin(), linked[v].end());
+                CHECK(adjacent_find(linked[v].begin(), linked[v].end()) == linked[v].end());
+            }
+
+            auto const [pooled_edges, pooled_degree, pooled] = generate_scale_free_graph(m0, m, n, seed, &pool);
+            CHECK_EQ(pooled_edges, edges);
+            for (int v = 0; v < g.size(); ++v)
+            {
+                auto const a = g.neighbours(v), b = pooled.neighbours(v);
+                CHECK(equal(a.begin(), a.end(), b.begin(), b.end()));
+            }
+        }
+}
@@ -0,0 +1,34 @@
+#include "check.h"
+#include "engine.h"
+#include "random.h"
+#include "util.h"
+
+using namespace std;
+
+// One flood standing in for lengths 2 to 4 against a separate search per length: the cycles of
+// every length, and the edges learned at the flood's own length, must be the same
+TEST(single_pass_matches_separate_runs)
+{
+    reseedThread(2);
+    group const G = getGroupParameters(20, 40);
+    constexpr int shortest = 2, longest = 4;
+    for (uint64_t graph_seed = 1; graph_seed <= 4; ++graph_seed)
+    {
+        graph const topology = get<2>(generate_scale_free_graph(4, 3 + (int) graph_seed % 2, 40, graph_seed));
+        simulation flood(topology, G, graph_seed);
+        run_options options;
+        options.shortest = shortest;
+        run_stats const single = run_serial(flood, longest, options);
+
+        for (int l = shortest; l <= longest; ++l)
+        {
+            simulation sim(topology, G, graph_seed);
+            run_stats const separate = run_serial(sim, l);
+            CHECK_EQ(single.at_length(l).cycles.raw(), separate.cycles.raw());
+            CHECK_EQ(single.at_length(l).cycles.unique(), separate.cycles.unique());
+            if (l < longest) continue;
+            CHECK_EQ(single.known_edges, separate.known_edges);
+            CHECK_EQ(single.known_bytes, separate.known_bytes);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#include <queue>
+#include <tuple>
+#include <vector>
+#include "check.h"
+#include "random.h"
+#include "timing_wheel.h"
+
+using namespace std;
+
+namespace
+{
+    // Delays from zero, which ties with items due now, up to ones reaching the top level; the small
+    // ones are rounded so that many items share a due time
+    uint64_t random_delay()
+    {
+        switch (getRandomBelow(8))
+        {
+            case 0: return 0;
+            case 1: case 2: case 3: return getRandomBelow(16) * 16;
+            case 4: case 5: return getRandomBelow(1 << 20);
+            case 6: return getRandomBelow(1ULL << 40);
+            default: return getRandomBelow(1ULL << 62);
+        }
+    }
+
+    // The order the wheel must reproduce: earliest due time first, then the order pushed
+    struct reference_queue
+    {
+        using item = tuple<uint64_t, uint64_t, uint32_t>;      // due, push sequence, id
+        priority_queue<item, vector<item>, greater<>> heap;
+        uint64_t sequence = 0;
+
+        void push(uint32_t id, uint64_t due) { heap.emplace(due, sequence++, id); }
+        item pop()
+        {
+            item const top = heap.top();
+            heap.pop();
+            return top;
+        }
+    };
+}
+
+// Random pushes and pops, including due times already past, against a binary heap
+TEST(timing_wheel_matches_heap)
+{
+    reseedThread(1);
+    constexpr int operations = 2000000;
+    constexpr uint32_t ids = 4096;
+
+    timing_wheel wheel;
+    reference_queue reference;
+    vector<uint32_t> free_ids;
+    for (uint32_t id = ids; id-- > 0;) free_ids.push_back(id);
+    uint64_t const start = 1ULL << 33;
+    wheel.clear(start);
+    uint64_t now = start;
+
+    for (int k = 0; k < operations; ++k)
+    {
+        // Pushes outnumber pops while the wheel is nearly empty and the other way round when full
+        bool const push = !free_ids.empty() && getRandomBelow(ids) < free_ids.size();
+        if (push)
+        {
+            uint32_t const id = free_ids.back();
+            free_ids.pop_back();
+            uint64_t const delay = random_delay();
+            bool const past = getRandomBelow(16) == 0 && now > start;
+            uint64_t const due = past ? now - 1 - getRandomBelow(now - start) : now + delay;
+            wheel.push(id, due);
+            reference.push(id, max(due, now));
+            continue;
+        }
+        uint32_t id = UINT32_MAX;
+        bool const popped = wheel.pop(id);
+        CHECK(popped);
+        if (!popped) return;
+        auto const [due, sequence, expected] = reference.pop();
+        CHECK_EQ(id, expected);
+        CHECK_EQ(wheel.now(), due);
+        now = due;
+        free_ids.push_back(id);
+        CHECK_EQ(wheel.size(), reference.heap.size());
+    }
+
+    while (!reference.heap.empty())
+    {
+        uint32_t id = UINT32_MAX;
+        CHECK(wheel.pop(id));
+        auto const [due, sequence, expected] = reference.pop();
+        CHECK_EQ(id, expected);
+        CHECK_EQ(wheel.now(), due);
+    }
+    uint32_t id;
+    CHECK(!wheel.pop(id));
+    CHECK(wheel.empty());
+}
+
+// Items pushed for one time come out in push order, wherever in the wheel they were waiting
+TEST(timing_wheel_fifo_ties)
+{
+    timing_wheel wheel;
+    for (uint64_t due : initializer_list<uint64_t>{ 0, 255, 256, 65537, 1ULL << 40, UINT64_MAX })
+    {
+        wheel.clear(0);
+        for (uint32_t id = 0; id < 100; ++id) wheel.push(id, due);
+        for (uint32_t expected = 0; expected < 100; ++expected)
+        {
+            uint32_t id = UINT32_MAX;
+            CHECK(wheel.pop(id));
+            CHECK_EQ(id, expected);
+            CHECK_EQ(wheel.now(), due);
+        }
+        CHECK(wheel.empty());
+    }
+}
@@ -0,0 +1,119 @@
+#include <stdexcept>
+#include <vector>
+#include "check.h"
+#include "random.h"
+#include "wire.h"
+
+using namespace std;
+
+namespace
+{
+    // Values around the varint length steps, then random ones
+    uint64_t field(int k, uint64_t bound)
+    {
+        uint64_t const steps[] = { 0, 1, 127, 128, 16383, 16384, (1ULL << 31) - 1, UINT64_MAX };
+        uint64_t const value = k < (int) size(steps) ? steps[k] : getRandomBelow(UINT64_MAX) >> getRandomBelow(64);
+        return bound ? value % bound : value;
+    }
+
+    template<typename E>
+    E random_element(int k)
+    {
+        if constexpr (is_same_v<E, uint64_t>) return field(k, 0);
+        else
+        {
+            E x;
+            for (auto &limb : x.limb) limb = field(k, 0);
+            return x;
+        }
+    }
+
+    // Messages of every type with fields of every varint length, some with valid_to set
+    template<group_backend G>
+    vector<basic_message<G>> random_messages(path_store& paths)
+    {
+        vector<basic_message<G>> messages;
+        for (int k = 0; k < 400; ++k)
+        {
+            path_ref path;
+            for (uint64_t i = 0, length = 1 + getRandomBelow(8); i < length; ++i) path = paths.extend(path, (int) field(k + (int) i, INT32_MAX));
+            auto const source = (int) field(k, INT32_MAX), target = (int) field(k + 1, INT32_MAX), l = (int) field(k + 2, INT32_MAX);
+            uint64_t const r = field(k + 3, 0);
+            auto const gx = random_element<typename G::element>(k);
+            switch (k % 4)
+            {
+                case 0: messages.emplace_back(source, target, r, gx, l); break;
+                case 1: messages.emplace_back(source, target, r, gx); break;
+                case 2: messages.emplace_back(source, target, r, gx, path); break;
+                default: messages.emplace_back(path); break;
+            }
+            messages.back().hop = (uint16_t) field(k, UINT16_MAX + 1);
+            if (k % 3 == 0) messages.back().valid_to = (uint16_t) field(k + 4, UINT16_MAX);
+        }
+        return messages;
+    }
+
+    // Encodes the messages into one batch and decodes them back one after another
+    template<group_backend G>
+    void round_trip(test_state& state)
+    {
+        path_store sent, received;
+        vector<basic_message<G>> const messages = random_messages<G>(sent);
+        vector<uint8_t> batch;
+        for (const auto &msg : messages) encode(msg, sent, batch);
+
+        span<const uint8_t> in = batch;
+        for (const auto &msg : messages)
+        {
+            span<const uint8_t> const before = in;
+            basic_message<G> const got = decode<G>(in, received);
+            CHECK_EQ((int) got.t, (int) msg.t);
+            CHECK_EQ(got.hop, msg.hop);
+            CHECK_EQ(got.valid_to, msg.valid_to);
+            if (msg.t != broadcast)
+            {
+                CHECK_EQ(got.source, msg.source);
+                CHECK_EQ(got.target, msg.target);
+                CHECK_EQ(got.r, msg.r);
+                CHECK(got.gx == msg.gx);
+            }
+            if (msg.t == f) CHECK_EQ(got.l, msg.l);
+            if (msg.t == p || msg.t == broadcast) CHECK(received.nodes(got.path) == sent.nodes(msg.path));
+
+            // Every proper prefix of the message is rejected rather than read past
+            size_t const length = before.size() - in.size();
+            for (size_t cut = 0; cut < length; ++cut)
+            {
+                span<const uint8_t> prefix = before.first(cut);
+                bool threw = false;
+                try { (void) decode<G>(prefix, received); } catch (const runtime_error&) { threw = true; }
+                CHECK(threw);
+            }
+        }
+        CHECK(in.empty());
+    }
+}
+
+TEST(varint_round_trip)
+{
+    vector<uint8_t> out;
+    vector<uint64_t> values;
+    for (int k = 0; k < 1000; ++k) put_varint(values.emplace_back(field(k, 0)), out);
+    span<const uint8_t> in = out;
+    for (uint64_t value : values) CHECK_EQ(get_varint(in), value);
+    CHECK(in.empty());
+
+    // Eleven continuation bytes are longer than any 64-bit value
+    vector<uint8_t> const overlong(11, 0x80);
+    span<const uint8_t> bad = overlong;
+    bool threw = false;
+    try { (void) get_varint(bad); } catch (const runtime_error&) { threw = true; }
+    CHECK(threw);
+}
+
+TEST(wire_round_trip)
+{
+    round_trip<small_group>(state);
+    round_trip<group>(state);
+    round_trip<modp2048>(state);
+}